@@ -75,8 +75,9 @@ void AlgorithmComparison::evaluateAlgorithm(const QVector<double> &x, const QVec
     allErrors<<ERR_AVERAGE_SED<<ERR_MAX_SED<<ERR_MEAN_SED<<ERR_AVERAGE_SSED_PER_POINT<<ERR_MAX_LSSED<<ERR_TIME_COST;
 
     // Evaluation statistucs.
-    QVector<double> xSum, ySum, tSum, x2Sum, y2Sum, t2Sum, xtSum, ytSum;
-    calculateStatisticsForSSED(x, y, t, xSum, ySum, tSum, x2Sum, y2Sum, t2Sum, xtSum, ytSum);
+    Helper::checkIntEqual(x.count(), y.count());
+    Helper::checkIntEqual(x.count(), t.count());
+    PrefixStatistics statistics(x.constData(), y.constData(), t.constData(), x.count());
 
     errorToEval.clear();
     double expStep = qPow(compressMax/compressMin, 1.0/((double)(numSteps-1)));
@@ -104,8 +105,7 @@ void AlgorithmComparison::evaluateAlgorithm(const QVector<double> &x, const QVec
 
                 if (err != ERR_TIME_COST)
                 {
-                    double simplifyError = evaluateResult(x, y, t, simplifiedIndex, err,
-                                                          xSum, ySum, tSum, x2Sum, y2Sum, t2Sum, xtSum, ytSum);
+                    double simplifyError = evaluateResult(x, y, t, simplifiedIndex, err, statistics);
                     //simplifyError = qLn(1.0+simplifyError);
                     errorToEval[err].append(EvaluationPoint(1.0/realRate, simplifyError));
                 }
@@ -125,14 +125,17 @@ void AlgorithmComparison::compareAlgorithms(QString fileName, int algorithmsToCo
     QVector<double> x,y,t;
     QElapsedTimer timer;
     timer.start();
-    if (fileName.endsWith(".txt")) // MOPSI dataset.
-        Helper::parseMOPSI(fileName, x, y, t);
-    else if (fileName.endsWith(".plt")) // GeoLife dataset.
-        Helper::parseGeoLife(fileName, x, y, t);
-    else
-        Helper::parseMOPSI2(fileName, x, y, t);
+    Helper::parseTrajectory(fileName, x, y, t);
     qDebug("Parsing file OK, time: %d ms.", timer.elapsed());
 
+#ifdef DOTS_STATS
+    // Dump hot-path statistics of DOTS at the default threshold.
+    DotsStats stats;
+    QVector<int> statsIndex;
+    DotsSimplifier::batchDotsByIndex(x, y, t, statsIndex, 1000.0, &stats);
+    qDebug("DOTS statistics:\n%s", stats.toString().c_str());
+#endif
+
     // Evaluation.
     QVector<int> allAlgorithms;
     allAlgorithms<<ALG_DOTS<<ALG_DOTS_CASCADE<<ALG_DP<<ALG_PERSISTENCE<<ALG_SQUISH<<ALG_MRPA<<ALG_TS<<ALG_OPWTR<<ALG_OPW;
@@ -261,14 +264,7 @@ void AlgorithmComparison::compareAlgorithmsByFolder(QString folderName, QString
         QElapsedTimer timer;
         timer.start();
         try {
-        if (fileName.endsWith(".txt")) // MOPSI dataset.
-            Helper::parseMOPSI(fileName, x, y, t);
-        else if (fileName.endsWith(".plt")) // GeoLife dataset.
-            Helper::parseGeoLife(fileName, x, y, t);
-        else if (fileName.endsWith(".csv")) // MIT Single Camera View.
-            Helper::parseMitScv(fileName, x, y, t);
-        else
-            Helper::parseMOPSI2(fileName, x, y, t);
+            Helper::parseTrajectory(fileName, x, y, t);
         } catch (DotsException e) {
             qDebug("Parsing file %s Error.", fileName.toStdString().c_str());
             continue;
@@ -488,27 +484,70 @@ double AlgorithmComparison::tryToSimplify(const QVector<double> &x, const QVecto
             param = 1000.0;
         double lb, ub;
         double cr = 0.0;
-        param*=2;
+        double tolerance = 0.1*compressRate;
         int maxItr=20;
-        while (cr < compressRate && (--maxItr)>0) {
-            param/=2;
+        if (algorithm == ALG_DOTS)
+        {
+            // A single pass in output budget mode, whose output is kept if it is within tolerance already.
             timer.start();
-            cr = generalSimplify(x, y, t, algorithm, param, simplifiedIndex);
+            param = DotsSimplifier::batchDotsByBudget(x, y, t, simplifiedIndex, qMax(2, qRound(x.count()*compressRate)),
+                                                      param);
             timeCost = (double)timer.nsecsElapsed()/(1.0e9);
-            //qDebug()<<algorithm<<", "<<cr<<", "<<compressRate<<", "<<param;
-        }
-        lb = param;
-        param/=2;
-        maxItr = 20;
-        while (cr >= compressRate && (--maxItr)>0) {
-            param*=2;
+            cr = (double)(simplifiedIndex.count())/((double)(x.count()));
+            if (qFabs(compressRate-cr) <= tolerance)
+                return timeCost;
+
+            // Otherwise the threshold it ended up with is close, so it is bracketed by a step or two of BRACKET_STEP.
+            const double BRACKET_STEP = 1.5;
             timer.start();
             cr = generalSimplify(x, y, t, algorithm, param, simplifiedIndex);
             timeCost = (double)timer.nsecsElapsed()/(1.0e9);
-            //qDebug()<<algorithm<<", "<<cr<<", "<<compressRate<<", "<<param;
+            lb = ub = param;
+            if (cr >= compressRate)
+            {
+                while (qFabs(compressRate-cr) > tolerance && cr >= compressRate && (--maxItr)>0) {
+                    lb = param;
+                    param*=BRACKET_STEP;
+                    timer.start();
+                    cr = generalSimplify(x, y, t, algorithm, param, simplifiedIndex);
+                    timeCost = (double)timer.nsecsElapsed()/(1.0e9);
+                }
+                ub = param;
+            }
+            else
+            {
+                while (qFabs(compressRate-cr) > tolerance && cr < compressRate && (--maxItr)>0) {
+                    ub = param;
+                    param/=BRACKET_STEP;
+                    timer.start();
+                    cr = generalSimplify(x, y, t, algorithm, param, simplifiedIndex);
+                    timeCost = (double)timer.nsecsElapsed()/(1.0e9);
+                }
+                lb = param;
+            }
+        }
+        else
+        {
+            param*=2;
+            while (cr < compressRate && (--maxItr)>0) {
+                param/=2;
+                timer.start();
+                cr = generalSimplify(x, y, t, algorithm, param, simplifiedIndex);
+                timeCost = (double)timer.nsecsElapsed()/(1.0e9);
+                //qDebug()<<algorithm<<", "<<cr<<", "<<compressRate<<", "<<param;
+            }
+            lb = param;
+            param/=2;
+            maxItr = 20;
+            while (cr >= compressRate && (--maxItr)>0) {
+                param*=2;
+                timer.start();
+                cr = generalSimplify(x, y, t, algorithm, param, simplifiedIndex);
+                timeCost = (double)timer.nsecsElapsed()/(1.0e9);
+                //qDebug()<<algorithm<<", "<<cr<<", "<<compressRate<<", "<<param;
+            }
+            ub = param;
         }
-        ub = param;
-        double tolerance = 0.1*compressRate;
 
         maxItr = 30;
         while (qFabs(compressRate-cr) > tolerance && ub>lb+1e-3 && (--maxItr)>0)
@@ -617,52 +656,10 @@ double AlgorithmComparison::generalSimplify(const QVector<double> &x, const QVec
     return (double)(simplifiedIndex.count())/((double)(x.count()));
 }
 
-void AlgorithmComparison::calculateStatisticsForSSED(
-        const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
-        QVector<double> &xSum, QVector<double> &ySum, QVector<double> &tSum,
-        QVector<double> &x2Sum, QVector<double> &y2Sum, QVector<double> &t2Sum,
-        QVector<double> &xtSum, QVector<double> &ytSum)
-{
-    xSum.clear();
-    ySum.clear();
-    tSum.clear();
-    x2Sum.clear();
-    y2Sum.clear();
-    t2Sum.clear();
-    xtSum.clear();
-    ytSum.clear();
-
-    xSum.append(x.at(0));
-    ySum.append(y.at(0));
-    tSum.append(t.at(0));
-    x2Sum.append(x.at(0)*x.at(0));
-    y2Sum.append(y.at(0)*y.at(0));
-    t2Sum.append(t.at(0)*t.at(0));
-    xtSum.append(x.at(0)*t.at(0));
-    ytSum.append(y.at(0)*t.at(0));
-    double px, py, pt;
-    for (int i=0; i<x.count()-1; ++i)
-    {
-        px = x.at(i);
-        py = y.at(i);
-        pt = t.at(i);
-        xSum.append(xSum[i]+px);
-        ySum.append(ySum[i]+py);
-        tSum.append(tSum[i]+pt);
-        x2Sum.append(x2Sum[i]+px*px);
-        y2Sum.append(y2Sum[i]+py*py);
-        t2Sum.append(t2Sum[i]+pt*pt);
-        xtSum.append(xtSum[i]+px*pt);
-        ytSum.append(ytSum[i]+py*pt);
-    }
-}
-
 double AlgorithmComparison::evaluateResult(
         const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
         const QVector<int> simplifiedIndex, int errorType,
-        const QVector<double> &xSum, const QVector<double> &ySum, const QVector<double> &tSum,
-        const QVector<double> &x2Sum, const QVector<double> &y2Sum, const QVector<double> &t2Sum,
-        const QVector<double> &xtSum, const QVector<double> &ytSum)
+        const PrefixStatistics &statistics)
 {
     Helper::checkIntEqual(simplifiedIndex.first(), 0);
     Helper::checkIntEqual(simplifiedIndex.last(), x.count()-1);
@@ -672,9 +669,7 @@ double AlgorithmComparison::evaluateResult(
         QVector<double> SSEDs;
         for(int i=0; i<simplifiedIndex.count()-1; ++i)
         {
-            SSEDs.append(getLSSD(simplifiedIndex.at(i), simplifiedIndex.at(i+1),
-                                 x, y, t,
-                                 xSum, ySum, tSum, x2Sum, y2Sum, t2Sum, xtSum, ytSum));
+            SSEDs.append(statistics.lssd(simplifiedIndex.at(i), simplifiedIndex.at(i+1)));
         }
         if (errorType == ERR_AVERAGE_SSED_PER_POINT)
         {
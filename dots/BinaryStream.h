@@ -0,0 +1,145 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief BinaryStream.h defines the BinaryWriter and BinaryReader classes used by DOTS snapshots.
+  * @author caoweiquan322
+  */
+#ifndef BINARYSTREAM_H
+#define BINARYSTREAM_H
+
+#include<cstddef>
+#include<cstring>
+#include<stdexcept>
+#include<string>
+#include<vector>
+
+/**
+ * @brief The BinaryWriter class appends plain values and arrays to a byte string in host byte order.
+ */
+class BinaryWriter
+{
+public:
+    /**
+     * @brief BinaryWriter constructs a writer appending to out.
+     * @param out is the byte string to append to.
+     */
+    explicit BinaryWriter(std::string &out) : out(out)
+    {
+    }
+
+    /**
+     * @brief write appends a plain value.
+     * @param value is the value.
+     */
+    template<typename T>
+    inline void write(T value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    /**
+     * @brief writeArray appends the element count followed by the elements.
+     * @param data is the first element.
+     * @param n is the number of elements.
+     */
+    template<typename T>
+    inline void writeArray(const T *data, int n)
+    {
+        write(n);
+        if (n > 0)
+            out.append(reinterpret_cast<const char *>(data), sizeof(T)*n);
+    }
+
+protected:
+    std::string &out;
+};
+
+/**
+ * @brief The BinaryReader class reads what BinaryWriter wrote. Reading past the end raises std::runtime_error.
+ */
+class BinaryReader
+{
+public:
+    /**
+     * @brief BinaryReader constructs a reader of a byte range.
+     * @param data is the first byte.
+     * @param size is the number of bytes.
+     */
+    BinaryReader(const char *data, size_t size) : pos(data), end(data+size)
+    {
+    }
+
+    /**
+     * @brief read reads a plain value.
+     * @return the value.
+     */
+    template<typename T>
+    inline T read()
+    {
+        T value;
+        take(&value, sizeof(T));
+        return value;
+    }
+
+    /**
+     * @brief readArray reads an element count and the elements.
+     * @param data receives the elements.
+     */
+    template<typename T>
+    inline void readArray(std::vector<T> &data)
+    {
+        int n = read<int>();
+        if (n < 0 || static_cast<size_t>(n) > static_cast<size_t>(end-pos)/sizeof(T))
+            throw std::runtime_error("Corrupted or truncated binary data.");
+        data.resize(n);
+        if (n > 0)
+            take(&data[0], sizeof(T)*n);
+    }
+
+    /**
+     * @brief skip steps over the next n bytes without copying them, e.g. to decode them in place.
+     * @param n is the number of bytes.
+     * @return the first of the bytes.
+     */
+    inline const char *skip(size_t n)
+    {
+        if (static_cast<size_t>(end-pos) < n)
+            throw std::runtime_error("Corrupted or truncated binary data.");
+        const char *data = pos;
+        pos += n;
+        return data;
+    }
+
+    /**
+     * @brief atEnd checks if all bytes were read.
+     * @return true if all bytes were read, false otherwise.
+     */
+    inline bool atEnd() const
+    {
+        return pos == end;
+    }
+
+protected:
+    /**
+     * @brief take copies the next n bytes.
+     * @param dest receives the bytes.
+     * @param n is the number of bytes.
+     */
+    inline void take(void *dest, size_t n)
+    {
+        if (static_cast<size_t>(end-pos) < n)
+            throw std::runtime_error("Corrupted or truncated binary data.");
+        memcpy(dest, pos, n);
+        pos += n;
+    }
+
+    const char *pos;
+    const char *end;
+};
+
+#endif // BINARYSTREAM_H
@@ -0,0 +1,124 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief ColumnCodec.h defines the ColumnCodec class, the column encoding of binary trajectory files.
+  * @author caoweiquan322
+  */
+#ifndef COLUMNCODEC_H
+#define COLUMNCODEC_H
+
+#include<cmath>
+#include<cstdint>
+#include<string>
+
+/**
+ * @brief The ColumnCodec class encodes a column of values, e.g. the x positions of a trajectory, as fixed-point
+ * integers, i.e. as multiples of a resolution. The differences between consecutive integers are stored as zig-zag
+ * varints: small differences of either sign take one or two bytes, which is what consecutive samples of a trajectory
+ * have at resolutions like millimeters and milliseconds.
+ *
+ * Decoding rounds each value to the nearest multiple of the resolution, i.e. it is exact up to half the resolution.
+ *
+ * The class is header-only and depends on the standard library only.
+ */
+class ColumnCodec
+{
+public:
+    /**
+     * @brief encode appends a column of values.
+     * @param values is the values.
+     * @param n is the number of values.
+     * @param resolution is the resolution the values are rounded to. It must be positive.
+     * @param out is the byte string to append to.
+     * @return true if the column was encoded, false if a value is not finite or too large for the resolution.
+     */
+    static bool encode(const double *values, int n, double resolution, std::string &out)
+    {
+        int64_t previous = 0;
+        for (int k=0; k<n; ++k)
+        {
+            double scaled = values[k]/resolution;
+            if (!(std::fabs(scaled) < MAX_FIXED_POINT))
+                return false;
+
+            int64_t q = std::llround(scaled);
+            uint64_t delta = zigZag(q-previous);
+            previous = q;
+            while (delta >= 0x80)
+            {
+                out.push_back(static_cast<char>(delta | 0x80));
+                delta >>= 7;
+            }
+            out.push_back(static_cast<char>(delta));
+        }
+        return true;
+    }
+
+    /**
+     * @brief decode reads a column of values written by encode().
+     * @param pos is the first byte of the column.
+     * @param end is one past the last readable byte.
+     * @param n is the number of values.
+     * @param resolution is the resolution the column was encoded with.
+     * @param values receives the values.
+     * @return one past the last byte of the column, or NULL if the column is truncated or corrupted.
+     */
+    static const char *decode(const char *pos, const char *end, int n, double resolution, double *values)
+    {
+        uint64_t q = 0;
+        for (int k=0; k<n; ++k)
+        {
+            // Most differences fit in one or two bytes.
+            if (pos >= end)
+                return NULL;
+            uint64_t delta = static_cast<unsigned char>(*pos++);
+            if (delta >= 0x80)
+            {
+                delta &= 0x7f;
+                for (int shift=7; ; shift+=7)
+                {
+                    if (pos >= end || shift > 63)
+                        return NULL;
+                    uint64_t byte = static_cast<unsigned char>(*pos++);
+                    delta |= (byte & 0x7f) << shift;
+                    if (byte < 0x80)
+                        break;
+                }
+            }
+
+            // Unsigned arithmetic wraps like the signed integers of encode(), even for corrupted data.
+            q += static_cast<uint64_t>(unZigZag(delta));
+            values[k] = static_cast<double>(static_cast<int64_t>(q))*resolution;
+        }
+        return pos;
+    }
+
+protected:
+    /**
+     * @brief zigZag maps signed integers to unsigned ones, so that small magnitudes of either sign stay small.
+     */
+    static inline uint64_t zigZag(int64_t v)
+    {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    /**
+     * @brief unZigZag is the inverse of zigZag().
+     */
+    static inline int64_t unZigZag(uint64_t v)
+    {
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    /**
+     * @brief MAX_FIXED_POINT bounds the fixed-point integers, so that their differences cannot overflow.
+     */
+    static constexpr double MAX_FIXED_POINT = 4611686018427387904.0;
+};
+
+#endif // COLUMNCODEC_H
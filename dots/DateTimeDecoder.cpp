@@ -0,0 +1,63 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+#include "DateTimeDecoder.h"
+#include<QByteArray>
+#include<QDate>
+#include<QDateTime>
+#include<QTime>
+#include<cstring>
+
+const QString DateTimeDecoder::FORMAT("yyyy-MM-ddHH:mm:ss");
+
+DateTimeDecoder::DateTimeDecoder()
+{
+    memset(cachedDate, 0, sizeof(cachedDate));
+    cached = false;
+    uniformDay = false;
+    dayEpoch = 0;
+}
+
+double DateTimeDecoder::decode(const TextField &date, const TextField &time)
+{
+    // The fast path needs "yyyy-MM-dd", one separator and "HH:mm:ss" in a row.
+    if (date.length() != 10 || time.length() != 8 || time.begin != date.end+1 || !TextScanner::isDateTime(date.begin))
+        return decodeByQt(date, time);
+
+    // Re-derive the epoch of the day only when the date changes.
+    if (!cached || memcmp(cachedDate, date.begin, sizeof(cachedDate)) != 0)
+        cacheDay(date.begin);
+    int hour = twoDigits(time.begin), minute = twoDigits(time.begin+3), second = twoDigits(time.begin+6);
+    if (!uniformDay || hour > 23 || minute > 59 || second > 59)
+        return decodeByQt(date, time);
+
+    // Like QDateTime::toTime_t(), times out of the range of uint are (uint)-1.
+    qint64 timestamp = dayEpoch+hour*3600+minute*60+second;
+    if (quint64(timestamp) >= Q_UINT64_C(0xFFFFFFFF))
+        return (double)uint(-1);
+    return (double)timestamp;
+}
+
+double DateTimeDecoder::decodeByQt(const TextField &date, const TextField &time) const
+{
+    QByteArray dateTime(date.begin, date.length());
+    dateTime.append(time.begin, time.length());
+    return (double)QDateTime::fromString(dateTime, FORMAT).toTime_t();
+}
+
+void DateTimeDecoder::cacheDay(const char *date)
+{
+    memcpy(cachedDate, date, sizeof(cachedDate));
+    cached = true;
+
+    // The day is uniform if it has 24 hours at one UTC offset, i.e. no DST transition falls into it.
+    QDate day(twoDigits(date)*100+twoDigits(date+2), twoDigits(date+5), twoDigits(date+8));
+    QDateTime midnight(day, QTime(0, 0)), nextMidnight(day.addDays(1), QTime(0, 0));
+    uniformDay = day.isValid() && midnight.isValid() && nextMidnight.isValid()
+            && midnight.offsetFromUtc() == nextMidnight.offsetFromUtc()
+            && nextMidnight.toMSecsSinceEpoch()-midnight.toMSecsSinceEpoch() == 86400000;
+    dayEpoch = uniformDay ? midnight.toMSecsSinceEpoch()/1000 : 0;
+}
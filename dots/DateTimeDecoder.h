@@ -0,0 +1,78 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief DateTimeDecoder.h defines the DateTimeDecoder class, the timestamp decoder of the MOPSI parser.
+  * @author caoweiquan322
+  */
+#ifndef DATETIMEDECODER_H
+#define DATETIMEDECODER_H
+
+#include<QString>
+#include<QtGlobal>
+#include"TextScanner.h"
+
+/**
+ * @brief The DateTimeDecoder class converts local date and time fields of the fixed-width forms "yyyy-MM-dd" and
+ * "HH:mm:ss" to Unix timestamps, with the same results as QDateTime::fromString(date+time, "yyyy-MM-ddHH:mm:ss")
+ * followed by QDateTime::toTime_t().
+ *
+ * Consecutive points of a trajectory mostly share their date, so the epoch of the local midnight is cached and only
+ * re-derived when the date changes. A timestamp is then the cached epoch plus the seconds of the day, which holds
+ * as long as the UTC offset is the same all day. Days with a DST transition, fields of another form and invalid
+ * values are decoded by QDateTime as before.
+ */
+class DateTimeDecoder
+{
+public:
+    /**
+     * @brief DateTimeDecoder constructs a decoder with an empty cache.
+     */
+    DateTimeDecoder();
+
+    /**
+     * @brief decode converts a date field and a time field to a Unix timestamp.
+     * @param date is the date field.
+     * @param time is the time field.
+     * @return the timestamp, or (uint)-1 if they are not a valid local time within the range of toTime_t().
+     */
+    double decode(const TextField &date, const TextField &time);
+
+protected:
+    /**
+     * @brief decodeByQt converts the fields by QDateTime.
+     */
+    double decodeByQt(const TextField &date, const TextField &time) const;
+
+    /**
+     * @brief cacheDay derives the epoch of the local midnight of a date of the form "yyyy-MM-dd".
+     * @param date is the first character of the date.
+     */
+    void cacheDay(const char *date);
+
+    /**
+     * @brief twoDigits converts two digits.
+     */
+    static inline int twoDigits(const char *text)
+    {
+        return (text[0]-'0')*10+(text[1]-'0');
+    }
+
+    /**
+     * @brief FORMAT is the format QDateTime parses the concatenated fields by.
+     */
+    static const QString FORMAT;
+
+    // The cached date, whether the cache is filled, whether the UTC offset is the same all day and the epoch of the
+    // local midnight in seconds.
+    char cachedDate[10];
+    bool cached;
+    bool uniformDay;
+    qint64 dayEpoch;
+};
+
+#endif // DATETIMEDECODER_H
@@ -0,0 +1,1991 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief DotsCore.h defines the DotsCore class, the DOTS engine without Qt dependency.
+  * @author caoweiquan322
+  */
+#ifndef DOTSCORE_H
+#define DOTSCORE_H
+
+#include<algorithm>
+#include<cassert>
+#include<cstddef>
+#include<cmath>
+#include<stdexcept>
+#include<string>
+#include<vector>
+#include"BinaryStream.h"
+#include"DotsStats.h"
+#include"DotsStatus.h"
+#include"LssdKernel.h"
+#include"PrefixStatistics.h"
+
+/**
+ * @brief The DotsCore class implements the DOTS algorithm in plain C++. It is header-only and depends on the standard
+ * library only, so it could be embedded in services that do not run a Qt event loop. DotsSimplifier is the Qt adapter
+ * on top of it.
+ *
+ * A DotsCore is a value: it is constructed on the stack or inside containers and owns all its state. It is move-only,
+ * as cascade levels refer to each other by address; moving a cascade root or level updates the references of the
+ * other levels.
+ *
+ * Misuse like feeding after finish() raises std::logic_error, and out of range indices raise std::out_of_range.
+ * Services that must not throw use the try*() methods, which return a DotsStatus instead, or check the state once by
+ * checkFeedData() or checkFeedIndex() when a stream is opened and then feed by the *Unchecked() methods in the hot
+ * loop.
+ *
+ * N is the number of spatial axes and Scalar is the type the input data is stored in (see PrefixStatisticsT). The
+ * x/y methods are those of the 2D instantiation DotsCore; any dimension is fed by feedPoint() and read by
+ * readOutputPoint(), e.g. projected positions with altitude by DotsCore3D.
+ */
+template<int N, typename Scalar>
+class DotsCoreT
+{
+public:
+    /**
+     * @brief LssdPoint, LssdFrontier, LssdKernel and PrefixStatistics are the instantiations of this dimension.
+     */
+    typedef LssdPointT<N> LssdPoint;
+    typedef LssdFrontierT<N> LssdFrontier;
+    typedef LssdKernelT<N> LssdKernel;
+    typedef PrefixStatisticsT<N, Scalar> PrefixStatistics;
+
+    /**
+     * @brief DIMENSION is the number of spatial axes.
+     */
+    static const int DIMENSION = N;
+
+    /**
+     * @brief DotsCore is the default constructor.
+     * @param cascadeRoot is the root simplifier of the cascade this simplifier joins, or NULL for a root simplifier.
+     */
+    explicit DotsCoreT(DotsCoreT *cascadeRoot = NULL)
+    {
+        lssdTh = 10000.0;
+        lssdFactor = 2.0;
+        lssdUpperBound = lssdTh*lssdFactor;
+        maxVkSize = 1e6;
+        streaming = false;
+        budgetRatio = 0;
+        maxDelayPoints = 0;
+        maxDelaySeconds = 0;
+        resetInternalData();
+
+        // Assign reference to the root DOTS simplifier.
+        isCascadeRoot = (cascadeRoot == NULL);
+        if (isCascadeRoot)
+            cascadeRoot = this;
+        else
+            cascadeRoot->cascadeChildren.push_back(this);
+        rootSimplifier = cascadeRoot;
+        pStatistics = &(cascadeRoot->statistics);
+        streaming = cascadeRoot->streaming;
+    }
+
+    /**
+     * @brief DotsCore is the move constructor. The other simplifier is left detached and must not be used anymore.
+     * @param other is the simplifier to move.
+     */
+    DotsCoreT(DotsCoreT &&other)
+    {
+        rootSimplifier = NULL;
+        isCascadeRoot = true;
+        takeOver(other);
+    }
+
+    /**
+     * @brief operator = moves another simplifier. The other simplifier is left detached and must not be used anymore.
+     * @param other is the simplifier to move.
+     * @return this simplifier.
+     */
+    DotsCoreT &operator=(DotsCoreT &&other)
+    {
+        if (this != &other)
+        {
+            detach();
+            takeOver(other);
+        }
+        return *this;
+    }
+
+    DotsCoreT(const DotsCoreT &) = delete;
+    DotsCoreT &operator=(const DotsCoreT &) = delete;
+
+    /**
+     * @brief ~DotsCore detaches this simplifier from its cascade root or cascade children.
+     */
+    ~DotsCoreT()
+    {
+        detach();
+    }
+
+    /**
+     * @brief setParameters specifies DOTS settings for trajectory simplification.
+     * @param lssdTh is the LSSD threshold for DAG searching.
+     * @param k is the factor for upper bound. LSSD that exceeds lssdTh*k would be ignored by DAG searching.
+     * @param maxVkSize is the maximum size of each layer of DAG tree.
+     */
+    void setParameters(double lssdTh, double k = 2.0, int maxVkSize = 1e6)
+    {
+        this->lssdTh = lssdTh;
+        lssdFactor = k;
+        lssdUpperBound = lssdTh*k;
+        this->maxVkSize = maxVkSize;
+    }
+
+    /**
+     * @brief setOutputBudget enables or disables the output budget (min-#) mode. In this mode the simplifier aims at
+     * a given ratio of output points to input points instead of a fixed error bound: the LSSD threshold set by
+     * setParameters() is the initial guess only, and it is adapted while the DAG search proceeds, so that a single
+     * pass ends up close to the budget. Each layer of the DAG adds one point to the simplified path, so the ratio of
+     * layers to decided inputs is steered toward the budget, both over the recent layers and over the whole
+     * trajectory. The first layers measure the threshold from the fed data rather than adapt the initial guess, so
+     * that budgets of a few points per trajectory are met as well (see adaptThreshold()). getLssdThreshold() reports
+     * the current threshold, which is kept by resetInternalData() as a warm start for the next trajectory.
+     * @param ratio is the target ratio of output points to input points in (0, 1], or 0 to disable the mode.
+     */
+    void setOutputBudget(double ratio)
+    {
+        if (ratio < 0 || ratio > 1)
+            throw std::out_of_range("The output budget ratio " + std::to_string(ratio) + " is out of range [0, 1].");
+        budgetRatio = ratio;
+    }
+
+    /**
+     * @brief setStreamingMode enables or disables the bounded-memory streaming mode. In streaming mode the committed
+     * prefix of the trajectory (everything before the last committed point that was already read) is dropped from
+     * internal containers and the prefix sums are rebased, so memory is bounded by the decision window instead of
+     * the trajectory length. Points that were dropped are no longer accessible through getSimplifiedIndex(), and
+     * getMaxLSSD() is not supported in this mode.
+     *
+     * The mode applies to a whole cascade: setting it on the root sets it on all levels, and levels joining a cascade
+     * take it from the root, so that the committed prefixes of all levels are released together. The input data of
+     * the root is only dropped once no level refers to it anymore.
+     * @param enabled is true to enable streaming mode, false otherwise.
+     */
+    void setStreamingMode(bool enabled)
+    {
+        streaming = enabled;
+        for (size_t k=0; k<cascadeChildren.size(); ++k)
+            cascadeChildren[k]->streaming = enabled;
+    }
+
+    /**
+     * @brief setMaxDelay bounds the output latency. Normally a point is output once all DAG paths share it, which may
+     * take long on smooth parts of a trajectory where many paths stay alive. With a bound, whenever the point under
+     * evaluation gets further from the last output point than allowed, the DAG search is forced to commit: it starts a
+     * new layer at once and outputs the path to the element of the least ISSED within the bound, or links the point
+     * under evaluation to the path of the least ISSED if no element is within the bound (see forceCommit()). Either
+     * way, after every feed the newest point is within the bound from the last output point. This trades some accuracy
+     * for latency, as a forced link may exceed the LSSD threshold. getForcedCommitCount() reports how often the bound
+     * fired.
+     * @param maxPoints is the maximum number of input points between the last decided point and the newest one, or 0
+     * for no bound.
+     * @param maxSeconds is the maximum time between the last decided point and the newest one, or 0 for no bound.
+     */
+    void setMaxDelay(int maxPoints, double maxSeconds = 0)
+    {
+        if (maxPoints < 0 || maxSeconds < 0)
+            throw std::out_of_range("The maximum delay must not be negative.");
+        maxDelayPoints = maxPoints;
+        maxDelaySeconds = maxSeconds;
+    }
+
+    /**
+     * @brief getForcedCommitCount retrieves the number of commits forced by the maximum delay since the last reset.
+     * @return the number of forced commits.
+     */
+    int getForcedCommitCount() const
+    {
+        return forcedCommits;
+    }
+
+    /**
+     * @brief getStats retrieves the hot-path statistics since the last reset. They are collected only if DOTS_STATS
+     * is defined, and stay zero otherwise.
+     * @return the statistics.
+     */
+    const DotsStats &getStats() const
+    {
+        return stats;
+    }
+
+    /**
+     * @brief resetInternalData resets all internal data structures for DOTS algorithm.
+     */
+    void resetInternalData()
+    {
+        // Clear data points and internal statistics.
+        statistics.clear();
+        ptIndex.clear();
+
+        // Clear structures for DAG construction and optimization.
+        vK.clear();
+        vL.clear();
+        terminated.clear();
+        numTerminated = 0;
+        frontier.resize(0);
+        frontierLssd.clear();
+        frontierGeneration = -1;
+        vLLssd.clear();
+        vLLssdBegin.clear();
+        vLLssdCount.clear();
+        liveChildren.clear();
+        liveChildXor.clear();
+        issed.clear();
+        parents.clear();
+
+        // Input/output queue position.
+        simplifiedIndex.clear();
+        inputCount = 0;
+        outputCount = 0;
+
+        // Streaming offsets.
+        dataOffset = 0;
+        nodeOffset = 0;
+        outputOffset = 0;
+        issedOffset = 0;
+        dataGeneration = 0;
+
+        // Output budget and latency counters, and hot-path statistics.
+        forcedCommits = 0;
+        stats.clear();
+        budgetLayers = 0;
+        budgetWindowLayers = 0;
+        budgetWindowStart = 0;
+
+        // Finish flag.
+        finished = false;
+    }
+
+    /**
+     * @brief reserve allocates space for n input points, so that feeding up to n points does not reallocate the
+     * input data. Other cascade levels may then read the input data of a root simplifier from other threads while it
+     * is being fed, as long as they only access points that were fed before.
+     * @param n is the number of points.
+     */
+    void reserve(int n)
+    {
+        if (isCascadeRoot)
+            statistics.reserve(n);
+        else
+            ptIndex.reserve(n);
+        issed.reserve(n);
+        parents.reserve(n);
+        liveChildren.reserve(n);
+        liveChildXor.reserve(n);
+    }
+
+    /**
+     * @brief checkFeedData checks if feedData() and feedBatch() may be called, i.e. this simplifier is the cascade
+     * root and did not finish. The result holds until finish() or resetInternalData() is called.
+     * @return DOTS_OK if data may be fed, the reason otherwise.
+     */
+    inline DotsStatus checkFeedData() const noexcept
+    {
+        if (finished)
+            return DOTS_ERROR_FINISHED;
+        if (!isCascadeRoot)
+            return DOTS_ERROR_NOT_CASCADE_ROOT;
+        return DOTS_OK;
+    }
+
+    /**
+     * @brief checkFeedIndex checks if feedIndex() may be called, i.e. this simplifier is a cascade level other than
+     * the root and did not finish. The result holds until finish() or resetInternalData() is called.
+     * @return DOTS_OK if indices may be fed, the reason otherwise.
+     */
+    inline DotsStatus checkFeedIndex() const noexcept
+    {
+        if (finished)
+            return DOTS_ERROR_FINISHED;
+        if (isCascadeRoot)
+            return DOTS_ERROR_CASCADE_ROOT;
+        return DOTS_OK;
+    }
+
+    /**
+     * @brief feedData feeds a 2D spatio temporary point to DOTS. Positions and timestamps may be absolute values such
+     * as projected meters and Unix epoch seconds, as LSSD is evaluated relative to a local origin from compensated
+     * prefix sums (see PrefixStatisticsT).
+     * @param x is the x position.
+     * @param y is the y position.
+     * @param t is the timestamp.
+     */
+    inline void feedData(double x, double y, double t)
+    {
+        static_assert(N == 2, "Points of this dimension are fed by feedPoint().");
+        const double position[2] = {x, y};
+        feedPoint(position, t);
+    }
+
+    /**
+     * @brief tryFeedData is the exception-free version of feedData().
+     * @param x is the x position.
+     * @param y is the y position.
+     * @param t is the timestamp.
+     * @return DOTS_OK if the point was fed, the reason otherwise.
+     */
+    inline DotsStatus tryFeedData(double x, double y, double t) noexcept
+    {
+        static_assert(N == 2, "Points of this dimension are fed by tryFeedPoint().");
+        const double position[2] = {x, y};
+        return tryFeedPoint(position, t);
+    }
+
+    /**
+     * @brief feedDataUnchecked is feedData() without the state check. checkFeedData() must have returned DOTS_OK.
+     * @param x is the x position.
+     * @param y is the y position.
+     * @param t is the timestamp.
+     */
+    inline void feedDataUnchecked(double x, double y, double t) noexcept
+    {
+        static_assert(N == 2, "Points of this dimension are fed by feedPointUnchecked().");
+        const double position[2] = {x, y};
+        feedPointUnchecked(position, t);
+    }
+
+    /**
+     * @brief feedPoint feeds a spatio temporary point of any dimension to DOTS, like feedData() does in 2D.
+     * @param position is the position along each of the N axes.
+     * @param t is the timestamp.
+     */
+    inline void feedPoint(const double *position, double t)
+    {
+        DotsStatus status = checkFeedData();
+        if (status != DOTS_OK)
+            throwStatus(status);
+        feedPointUnchecked(position, t);
+    }
+
+    /**
+     * @brief tryFeedPoint is the exception-free version of feedPoint().
+     * @param position is the position along each of the N axes.
+     * @param t is the timestamp.
+     * @return DOTS_OK if the point was fed, the reason otherwise.
+     */
+    inline DotsStatus tryFeedPoint(const double *position, double t) noexcept
+    {
+        DotsStatus status = checkFeedData();
+        if (status == DOTS_OK)
+            feedPointUnchecked(position, t);
+        return status;
+    }
+
+    /**
+     * @brief feedPointUnchecked is feedPoint() without the state check. checkFeedData() must have returned DOTS_OK.
+     * @param position is the position along each of the N axes.
+     * @param t is the timestamp.
+     */
+    inline void feedPointUnchecked(const double *position, double t) noexcept
+    {
+        assert(checkFeedData() == DOTS_OK);
+
+        // Store data and update the prefix sums. Nodes of the root are the input points themselves.
+        statistics.append(position, t);
+        // Initialize issed&parents and the path tree.
+        issed.push_back(0);
+        parents.push_back(-1);
+        liveChildren.push_back(0);
+        liveChildXor.push_back(0);
+        // Update internal data.
+        if (nodeOffset+nodeCount() == 1)
+            startDag();
+    }
+
+    /**
+     * @brief feedBatch feeds n 2D spatio temporary points to DOTS at once. It checks the state once, reserves space
+     * once and computes the prefix sums in one loop. Feeding a batch and then reading outputs gives the same result as
+     * feeding the points one by one and then reading outputs.
+     * @param x is the x positions.
+     * @param y is the y positions.
+     * @param t is the timestamps.
+     * @param n is the number of points.
+     */
+    inline void feedBatch(const double *x, const double *y, const double *t, size_t n)
+    {
+        static_assert(N == 2, "Points of this dimension are fed by feedBatch(position, t, n).");
+        const double *position[2] = {x, y};
+        feedBatch(position, t, n);
+    }
+
+    /**
+     * @brief tryFeedBatch is the exception-free version of feedBatch().
+     * @param x is the x positions.
+     * @param y is the y positions.
+     * @param t is the timestamps.
+     * @param n is the number of points.
+     * @return DOTS_OK if the points were fed, the reason otherwise.
+     */
+    inline DotsStatus tryFeedBatch(const double *x, const double *y, const double *t, size_t n) noexcept
+    {
+        static_assert(N == 2, "Points of this dimension are fed by tryFeedBatch(position, t, n).");
+        const double *position[2] = {x, y};
+        return tryFeedBatch(position, t, n);
+    }
+
+    /**
+     * @brief feedBatchUnchecked is feedBatch() without the state check. checkFeedData() must have returned DOTS_OK.
+     * @param x is the x positions.
+     * @param y is the y positions.
+     * @param t is the timestamps.
+     * @param n is the number of points.
+     */
+    inline void feedBatchUnchecked(const double *x, const double *y, const double *t, size_t n) noexcept
+    {
+        static_assert(N == 2, "Points of this dimension are fed by feedBatchUnchecked(position, t, n).");
+        const double *position[2] = {x, y};
+        feedBatchUnchecked(position, t, n);
+    }
+
+    /**
+     * @brief feedBatch feeds n spatio temporary points of any dimension to DOTS at once, like the 2D version does.
+     * @param position is the positions along each of the N axes, i.e. position[a][k] is the position of the k-th
+     * point along axis a.
+     * @param t is the timestamps.
+     * @param n is the number of points.
+     */
+    inline void feedBatch(const double *const *position, const double *t, size_t n)
+    {
+        DotsStatus status = checkFeedData();
+        if (status != DOTS_OK)
+            throwStatus(status);
+        feedBatchUnchecked(position, t, n);
+    }
+
+    /**
+     * @brief tryFeedBatch is the exception-free version of feedBatch().
+     * @param position is the positions along each of the N axes.
+     * @param t is the timestamps.
+     * @param n is the number of points.
+     * @return DOTS_OK if the points were fed, the reason otherwise.
+     */
+    inline DotsStatus tryFeedBatch(const double *const *position, const double *t, size_t n) noexcept
+    {
+        DotsStatus status = checkFeedData();
+        if (status == DOTS_OK)
+            feedBatchUnchecked(position, t, n);
+        return status;
+    }
+
+    /**
+     * @brief feedBatchUnchecked is feedBatch() without the state check. checkFeedData() must have returned DOTS_OK.
+     * @param position is the positions along each of the N axes.
+     * @param t is the timestamps.
+     * @param n is the number of points.
+     */
+    inline void feedBatchUnchecked(const double *const *position, const double *t, size_t n) noexcept
+    {
+        assert(checkFeedData() == DOTS_OK);
+        if (n == 0)
+            return;
+
+        // Store data and update the prefix sums.
+        statistics.append(position, t, static_cast<int>(n));
+        int begin = nodeCount();
+        int count = begin+static_cast<int>(n);
+        // Initialize issed&parents and the path tree.
+        issed.resize(count, 0);
+        parents.resize(count, -1);
+        liveChildren.resize(count, 0);
+        liveChildXor.resize(count, 0);
+        // Update internal data.
+        if (nodeOffset+begin == 0)
+            startDag();
+    }
+
+    /**
+     * @brief feedIndex feeds the index of a point output by the previous cascade level.
+     * @param index is index of the point in the input data of the cascade root.
+     */
+    inline void feedIndex(int index)
+    {
+        DotsStatus status = checkFeedIndex();
+        if (status != DOTS_OK)
+            throwStatus(status);
+        feedIndexUnchecked(index);
+    }
+
+    /**
+     * @brief tryFeedIndex is the exception-free version of feedIndex().
+     * @param index is index of the point in the input data of the cascade root.
+     * @return DOTS_OK if the index was fed, the reason otherwise.
+     */
+    inline DotsStatus tryFeedIndex(int index) noexcept
+    {
+        DotsStatus status = checkFeedIndex();
+        if (status == DOTS_OK)
+            feedIndexUnchecked(index);
+        return status;
+    }
+
+    /**
+     * @brief feedIndexUnchecked is feedIndex() without the state check. checkFeedIndex() must have returned DOTS_OK.
+     * @param index is index of the point in the input data of the cascade root.
+     */
+    inline void feedIndexUnchecked(int index) noexcept
+    {
+        assert(checkFeedIndex() == DOTS_OK);
+
+        ptIndex.push_back(index);
+        // Initialize issed&parents and the path tree.
+        issed.push_back(0);
+        parents.push_back(-1);
+        liveChildren.push_back(0);
+        liveChildXor.push_back(0);
+        // Update internal data.
+        if (nodeOffset+nodeCount() == 1)
+            startDag();
+    }
+
+    /**
+     * @brief readOutputData checks if the simplifier outputs any data after the recent feeds. Output data will be
+     * stored in corresponding parameters if returned true.
+     * @param x the x value to output.
+     * @param y the y value to output.
+     * @param t the timestamp to output.
+     * @return true if there's output data, false otherwise.
+     */
+    inline bool readOutputData(double &x, double &y, double &t)
+    {
+        static_assert(N == 2, "Points of this dimension are read by readOutputPoint().");
+        double position[2];
+        if (!readOutputPoint(position, t))
+            return false;
+
+        x = position[0];
+        y = position[1];
+        return true;
+    }
+
+    /**
+     * @brief readOutputPoint is readOutputData() for any dimension.
+     * @param position receives the position along each of the N axes.
+     * @param t the timestamp to output.
+     * @return true if there's output data, false otherwise.
+     */
+    inline bool readOutputPoint(double *position, double &t)
+    {
+        int index = -1;
+        if (!readOutputIndex(index))
+            return false;
+
+        int dataOffset = rootSimplifier->dataOffset;
+        for (int a=0; a<N; ++a)
+            position[a] = pStatistics->position(index-dataOffset, a);
+        t = pStatistics->t(index-dataOffset);
+        return true;
+    }
+
+    /**
+     * @brief readOutputIndex checks if the simplifier outputs any data after the recent feeds. Output data will be
+     * stored in corresponding parameters if returned true.
+     * @param index the selected index to output.
+     * @return true if there's output data, false otherwise.
+     */
+    inline bool readOutputIndex(int &index)
+    {
+        // Run DAG search to produce potentially more output data.
+        if (!finished && outputCount >= outputOffset+outputSize())
+            directedAcyclicGraphSearch();
+
+        // Retrieve one data.
+        if (outputCount < outputOffset+outputSize())
+        {
+            index = position(simplifiedIndex[outputCount-outputOffset]);
+            ++outputCount;
+            DOTS_STATS_RECORD(stats.outputDelay.record(position(nodeOffset+nodeCount()-1)-index));
+
+            // Drop the committed prefix that would never be touched again.
+            if (streaming)
+                compactCommittedPrefix();
+            return true;
+        }
+        // No output yet.
+        return false;
+    }
+
+    /**
+     * @brief drainOutput runs the DAG search once and appends the indices of all points decided since the last read
+     * to output. It is equivalent to calling readOutputIndex() until it returns false.
+     * @param output receives the selected indices.
+     */
+    inline void drainOutput(std::vector<int> &output)
+    {
+        if (!finished)
+            directedAcyclicGraphSearch();
+
+        while (outputCount < outputOffset+outputSize())
+        {
+            output.push_back(position(simplifiedIndex[outputCount-outputOffset]));
+            ++outputCount;
+            DOTS_STATS_RECORD(stats.outputDelay.record(position(nodeOffset+nodeCount()-1)-output.back()));
+        }
+
+        // Drop the committed prefix that would never be touched again.
+        if (streaming)
+            compactCommittedPrefix();
+    }
+
+    /**
+     * @brief getSimplifiedIndex retrieves index of the i-th point of simplified trajectory.
+     * @param i the point number of simplified trajectory to retrieve.
+     * @return index of the i-th point.
+     */
+    inline int getSimplifiedIndex(int i) const
+    {
+        if (i<outputOffset || i>=outputOffset+outputSize())
+            throwOutOfRange(i);
+        return getSimplifiedIndexUnchecked(i);
+    }
+
+    /**
+     * @brief tryGetSimplifiedIndex is the exception-free version of getSimplifiedIndex().
+     * @param i the point number of simplified trajectory to retrieve.
+     * @param index receives index of the i-th point.
+     * @return DOTS_OK if the index was retrieved, DOTS_ERROR_OUT_OF_RANGE otherwise.
+     */
+    inline DotsStatus tryGetSimplifiedIndex(int i, int &index) const noexcept
+    {
+        if (i<outputOffset || i>=outputOffset+outputSize())
+            return DOTS_ERROR_OUT_OF_RANGE;
+        index = getSimplifiedIndexUnchecked(i);
+        return DOTS_OK;
+    }
+
+    /**
+     * @brief getSimplifiedIndexUnchecked is getSimplifiedIndex() without the range check. i must be in range
+     * [getOutputBegin(), getOutputEnd()).
+     * @param i the point number of simplified trajectory to retrieve.
+     * @return index of the i-th point.
+     */
+    inline int getSimplifiedIndexUnchecked(int i) const noexcept
+    {
+        assert(i>=outputOffset && i<outputOffset+outputSize());
+        return position(simplifiedIndex[i-outputOffset]);
+    }
+
+    /**
+     * @brief getOutputBegin retrieves the first point number of simplified trajectory that is still retrievable by
+     * getSimplifiedIndex(). It is 0 unless streaming mode dropped the committed prefix.
+     * @return the first point number.
+     */
+    inline int getOutputBegin() const noexcept
+    {
+        return outputOffset;
+    }
+
+    /**
+     * @brief getOutputEnd retrieves one past the last point number of simplified trajectory decided so far.
+     * @return one past the last point number.
+     */
+    inline int getOutputEnd() const noexcept
+    {
+        return outputOffset+outputSize();
+    }
+
+    /**
+     * @brief finish sets the finish flag for DOTS algorithm. No more data could be feeded after calling this method.
+     */
+    void finish()
+    {
+        if (!finished)
+        {
+            finished = true;
+            // Run DAG search once again to finish the simplification work.
+            directedAcyclicGraphSearch();
+        }
+    }
+
+    /**
+     * @brief getLssdThreshold retrieves the LSSD threshold used in this simplifier.
+     * @return the LSSD threshold used in this simplifier.
+     */
+    double getLssdThreshold() const
+    {
+        return lssdTh;
+    }
+
+    /**
+     * @brief getAverageSED gets the average SED error. Note that this method must be called after finish().
+     * @return the average SED error.
+     */
+    double getAverageSED() const
+    {
+        if (!finished)
+            throw std::logic_error("Calling getAverageSSED() is not allowed before finished feeding data.");
+        if (inputCount<1)
+            throw std::logic_error("No data points in the containers.");
+
+        return std::sqrt((issed[inputCount-1-nodeOffset]+issedOffset)/inputCount);
+    }
+
+    /**
+     * @brief getMaxLSSD retrieves the maximum LSSD generated during the simplification. Note that this method must
+     * be called after finish().
+     * @return the maximum LSSD.
+     */
+    double getMaxLSSD() const
+    {
+        if (!finished)
+            throw std::logic_error("Calling getMaxLSSD() is not allowed before finished feeding data.");
+        if (streaming || nodeOffset > 0)
+            throw std::logic_error("Calling getMaxLSSD() is not supported in streaming mode or after restoreState().");
+        if (inputCount<1)
+            throw std::logic_error("No data points in the containers.");
+
+        // LSSD
+        double ret = 0;
+        int node = inputCount-1;
+        do
+        {
+            int parentNode = parents[node];
+            double lssd = issed[node]-issed[parentNode];
+            if (ret < lssd)
+                ret = lssd;
+            node = parentNode;
+        } while (node>0);
+
+        return ret;
+    }
+
+    /**
+     * @brief saveState writes a snapshot of this simplifier and all its cascade levels, so that the simplification
+     * could be continued by restoreState() in another process, e.g. after a crash or a migration. Only the live window
+     * is written: the outputs that were not read yet, the DAG nodes the search or decoding may still touch and the
+     * input data they refer to. The committed and read prefix is left out whether or not streaming mode dropped it
+     * from memory, so the size of a snapshot is proportional to the decision window. Snapshots are in host byte order.
+     * @param out receives the snapshot.
+     */
+    void saveState(std::string &out) const
+    {
+        if (!isCascadeRoot)
+            throw std::logic_error("Only the cascade root could save the state of a cascade.");
+
+        // Find the live window of every level, and the input data any of them refers to.
+        int levels = 1+static_cast<int>(cascadeChildren.size());
+        std::vector<int> firstNode(levels), firstOutput(levels);
+        int firstData = dataOffset+statistics.count();
+        for (int k=0; k<levels; ++k)
+        {
+            const DotsCoreT *level = (k == 0) ? this : cascadeChildren[k-1];
+            level->liveWindow(firstNode[k], firstOutput[k]);
+            for (int node=firstNode[k]; node<level->nodeOffset+level->nodeCount(); ++node)
+            {
+                if (level->position(node) < firstData)
+                    firstData = level->position(node);
+            }
+        }
+        // A point evaluated as the last point of a segment reads the prefix sums of the preceding point.
+        firstData = std::max(dataOffset, firstData-1);
+
+        out.clear();
+        BinaryWriter writer(out);
+        writer.write(SNAPSHOT_MAGIC);
+        writer.write(SNAPSHOT_VERSION);
+        writer.write(levels);
+        writer.write(firstData);
+        statistics.save(writer, firstData-dataOffset);
+        for (int k=0; k<levels; ++k)
+        {
+            const DotsCoreT *level = (k == 0) ? this : cascadeChildren[k-1];
+            level->saveLevel(writer, firstNode[k], firstOutput[k]);
+        }
+    }
+
+    /**
+     * @brief restoreState replaces the state of this simplifier and all its cascade levels by a snapshot written by
+     * saveState(). The cascade must have the same number of levels, created in the same order, as the one saved.
+     * Outside streaming mode, outputs continue exactly where the saved simplifier would have continued. In streaming
+     * mode the restored simplifier compacts its window at other points than the saved one would have, which rounds the
+     * rebased prefix sums differently, so outputs may differ where LSSD is within rounding of the threshold. As the
+     * committed prefix is not part of a snapshot, getSimplifiedIndex() covers the restored window only and
+     * getMaxLSSD() is not supported.
+     * @param data is the snapshot.
+     * @param size is the size of the snapshot in bytes.
+     */
+    void restoreState(const char *data, size_t size)
+    {
+        if (!isCascadeRoot)
+            throw std::logic_error("Only the cascade root could restore the state of a cascade.");
+
+        BinaryReader reader(data, size);
+        if (reader.read<int>() != SNAPSHOT_MAGIC || reader.read<int>() != SNAPSHOT_VERSION)
+            throw std::runtime_error("Not a DOTS snapshot, or a snapshot of an unsupported version.");
+        int levels = reader.read<int>();
+        if (levels != 1+static_cast<int>(cascadeChildren.size()))
+            throw std::runtime_error("The snapshot has " + std::to_string(levels) + " cascade levels, but the "
+                                     "simplifier has " + std::to_string(1+cascadeChildren.size()) + ".");
+        dataOffset = reader.read<int>();
+        statistics.load(reader);
+        ++dataGeneration;
+        for (int k=0; k<levels; ++k)
+        {
+            DotsCoreT *level = (k == 0) ? this : cascadeChildren[k-1];
+            level->loadLevel(reader);
+        }
+        if (!reader.atEnd())
+            throw std::runtime_error("Corrupted or truncated binary data.");
+    }
+
+protected:
+    /**
+     * @brief throwStatus raises the exception corresponding to an error status.
+     * @param status is the error status.
+     */
+    [[noreturn]] DOTS_COLD static void throwStatus(DotsStatus status)
+    {
+        if (status == DOTS_ERROR_OUT_OF_RANGE)
+            throw std::out_of_range(dotsStatusMessage(status));
+        throw std::logic_error(dotsStatusMessage(status));
+    }
+
+    /**
+     * @brief throwOutOfRange raises std::out_of_range for a point number of simplified trajectory.
+     * @param i is the point number.
+     */
+    [[noreturn]] DOTS_COLD void throwOutOfRange(int i) const
+    {
+        throw std::out_of_range("Index " + std::to_string(i) + " is out of range ["
+                                + std::to_string(outputOffset) + ", "
+                                + std::to_string(outputOffset+outputSize()) + ")");
+    }
+
+    /**
+     * @brief startDag sets up the DAG search at the first point, i.e. the initial Vk set {0} and the output queue
+     * starting at the first point.
+     */
+    inline void startDag()
+    {
+        // Setup the initial vK set {0}.
+        vK.push_back(0);
+        terminated.push_back(false);
+        numTerminated = 0;
+        refreshFrontier();
+
+        // Set input/output queue.
+        inputCount = 1;
+        outputCount = 0;
+        simplifiedIndex.push_back(0);
+    }
+
+    /**
+     * @brief nodeCount retrieves the number of retained nodes.
+     */
+    inline int nodeCount() const
+    {
+        return static_cast<int>(issed.size());
+    }
+
+    /**
+     * @brief position retrieves the position of a node in the input data of the cascade root. Nodes of the root are
+     * the input points themselves, so only the other levels map them through ptIndex.
+     * @param node is index of the node.
+     * @return the position in the input data.
+     */
+    inline int position(int node) const
+    {
+        return isCascadeRoot ? node : ptIndex[node-nodeOffset];
+    }
+
+    /**
+     * @brief outputSize retrieves the number of retained outputs.
+     */
+    inline int outputSize() const
+    {
+        return static_cast<int>(simplifiedIndex.size());
+    }
+
+    /**
+     * @brief detach unregisters this simplifier from its cascade root, or its cascade children from it.
+     */
+    void detach()
+    {
+        // Detach from the cascade so that the destruction order of the levels does not matter.
+        if (!isCascadeRoot && rootSimplifier != NULL)
+        {
+            std::vector<DotsCoreT *> &siblings = rootSimplifier->cascadeChildren;
+            siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+        }
+        for (size_t k=0; k<cascadeChildren.size(); ++k)
+            cascadeChildren[k]->rootSimplifier = NULL;
+        cascadeChildren.clear();
+        rootSimplifier = NULL;
+    }
+
+    /**
+     * @brief takeOver moves the state of another simplifier into this one, and redirects the cascade references from
+     * and to the other simplifier to this one.
+     * @param other is the simplifier to move.
+     */
+    void takeOver(DotsCoreT &other)
+    {
+        lssdTh = other.lssdTh;
+        lssdFactor = other.lssdFactor;
+        lssdUpperBound = other.lssdUpperBound;
+        maxVkSize = other.maxVkSize;
+        budgetRatio = other.budgetRatio;
+        maxDelayPoints = other.maxDelayPoints;
+        maxDelaySeconds = other.maxDelaySeconds;
+        forcedCommits = other.forcedCommits;
+        stats = other.stats;
+        budgetLayers = other.budgetLayers;
+        budgetWindowLayers = other.budgetWindowLayers;
+        budgetWindowStart = other.budgetWindowStart;
+        statistics = std::move(other.statistics);
+        ptIndex = std::move(other.ptIndex);
+        streaming = other.streaming;
+        dataOffset = other.dataOffset;
+        nodeOffset = other.nodeOffset;
+        outputOffset = other.outputOffset;
+        issedOffset = other.issedOffset;
+        vK = std::move(other.vK);
+        vL = std::move(other.vL);
+        terminated = std::move(other.terminated);
+        numTerminated = other.numTerminated;
+        frontier = std::move(other.frontier);
+        frontierLssd = std::move(other.frontierLssd);
+        frontierGeneration = other.frontierGeneration;
+        vLLssd = std::move(other.vLLssd);
+        vLLssdBegin = std::move(other.vLLssdBegin);
+        vLLssdCount = std::move(other.vLLssdCount);
+        dataGeneration = other.dataGeneration;
+        issed = std::move(other.issed);
+        parents = std::move(other.parents);
+        liveChildren = std::move(other.liveChildren);
+        liveChildXor = std::move(other.liveChildXor);
+        simplifiedIndex = std::move(other.simplifiedIndex);
+        inputCount = other.inputCount;
+        outputCount = other.outputCount;
+        finished = other.finished;
+
+        // Redirect the cascade references.
+        isCascadeRoot = other.isCascadeRoot;
+        cascadeChildren = std::move(other.cascadeChildren);
+        other.cascadeChildren.clear();
+        if (isCascadeRoot)
+        {
+            rootSimplifier = this;
+            for (size_t k=0; k<cascadeChildren.size(); ++k)
+            {
+                cascadeChildren[k]->rootSimplifier = this;
+                cascadeChildren[k]->pStatistics = &statistics;
+            }
+        }
+        else
+        {
+            rootSimplifier = other.rootSimplifier;
+            if (rootSimplifier != NULL)
+                std::replace(rootSimplifier->cascadeChildren.begin(), rootSimplifier->cascadeChildren.end(),
+                             &other, this);
+        }
+        pStatistics = (rootSimplifier != NULL) ? &(rootSimplifier->statistics) : &statistics;
+
+        // Leave the other simplifier detached.
+        other.isCascadeRoot = true;
+        other.rootSimplifier = NULL;
+        other.pStatistics = &(other.statistics);
+    }
+
+    /**
+     * @brief directedAcyclicGraphSearch does a DAG search among the feeded spatio-temporal 2D data. The output queue
+     * would be updated when appropriate.
+     */
+    inline void directedAcyclicGraphSearch()
+    {
+        int numPoints = nodeOffset+nodeCount();
+        if (finished)
+        {
+            // Construct the DAG completely.
+            while (true)
+            {
+                if (inputCount>=numPoints)
+                    break;
+
+                // Move v* points to vL.
+                for (int i=inputCount; i<numPoints; ++i)
+                {
+                    // Update vK if parent was not assigned yet.
+                    if (parents[i-nodeOffset] < 0)
+                    {
+                        for (int j=0;j<static_cast<int>(vK.size()); ++j)
+                        {
+                            // Evaluate LSSD against the frontier block by block.
+                            if (j%LSSD_BLOCK_SIZE == 0)
+                                evaluateFrontier(i, j, std::min(j+LSSD_BLOCK_SIZE, static_cast<int>(vK.size())));
+
+                            int jIndex = vK[j];
+                            if (!terminated[j])
+                            {
+                                double distance = frontierLssd[j];
+                                if (distance < lssdTh)
+                                {
+                                    appendVL(i, j);
+                                    issed[i-nodeOffset] = issed[jIndex-nodeOffset]+distance;
+                                    parents[i-nodeOffset] = jIndex;
+                                    break;
+                                }
+                                else if (distance > lssdUpperBound)
+                                {
+                                    terminated[j] = true;
+                                    ++numTerminated;
+
+                                    // Check if all vK terminated.
+                                    if (needUpdateVK())
+                                    {
+                                        break;
+                                    }
+                                }
+                            } // if (!terminated[j])
+                        } // for (int j=0;j<vK.size(); ++j)
+                    } // if (parents[i] < 0)
+
+                    // Update inputCount for consequent none v* points.
+                    if(parents[i-nodeOffset]>=0 && inputCount == i)
+                    {
+                        // Update start point of DAG search.
+                        ++inputCount;
+
+                        // Adapt the threshold if layers grow long past the budget.
+                        if (budgetRatio > 0 && (inputCount-budgetWindowStart)*budgetRatio >= budgetWindow())
+                            adaptThreshold();
+                    }
+
+                    // Terminate loop early if we need to update vK.
+                    if (needUpdateVK())
+                        break;
+                } // for (int i=inputCount; i<numPoints; ++i)
+
+                // Minimize ISSED.
+                minimizeISSED();
+
+                // Force swap vK/vL no matter we need update vK.
+                updateVK();
+
+                // Omit viterbi decoding!!
+            }
+
+            // Decode the simplified data from back to front.
+            std::vector<int> temp;
+            int idx = numPoints-1;
+            int currentIndex = -1;
+            if (!simplifiedIndex.empty())
+                currentIndex = simplifiedIndex.back();
+            while(idx>currentIndex)
+            {
+                temp.push_back(idx);
+                idx = parents[idx-nodeOffset];
+            }
+            for (int k=static_cast<int>(temp.size())-1; k>=0; --k)
+                simplifiedIndex.push_back(temp[k]);
+        } // if (finished)
+        else
+        {
+            while (true)
+            {
+                bool vKUpdated = false;
+                if (inputCount>=numPoints)
+                    break;
+
+                // Move v* points to vL.
+                for (int i=inputCount; i<numPoints; ++i)
+                {
+                    // Update vK if parent was not assigned yet.
+                    if (parents[i-nodeOffset] < 0)
+                    {
+                        for (int j=0;j<static_cast<int>(vK.size()); ++j)
+                        {
+                            // Evaluate LSSD against the frontier block by block.
+                            if (j%LSSD_BLOCK_SIZE == 0)
+                                evaluateFrontier(i, j, std::min(j+LSSD_BLOCK_SIZE, static_cast<int>(vK.size())));
+
+                            int jIndex = vK[j];
+                            if (!terminated[j])
+                            {
+                                double distance = frontierLssd[j];
+                                if (distance < lssdTh)
+                                {
+                                    appendVL(i, j);
+                                    issed[i-nodeOffset] = issed[jIndex-nodeOffset]+distance;
+                                    parents[i-nodeOffset] = jIndex;
+
+                                    // Check if vL exceeds max size.
+                                    if (needUpdateVK())
+                                    {
+                                        // Minimize ISSED.
+                                        minimizeISSED();
+
+                                        // Swap vK/vL
+                                        updateVK();
+
+                                        // Viterbi decoding.
+                                        viterbiDecode();
+
+                                        // Break search loop.
+                                        vKUpdated = true;
+                                    }
+                                    break;
+                                }
+                                else if (distance > lssdUpperBound)
+                                {
+                                    terminated[j] = true;
+                                    ++numTerminated;
+
+                                    // Check if all vK terminated.
+                                    if (needUpdateVK())
+                                    {
+                                        // Minimize ISSED.
+                                        minimizeISSED();
+
+                                        // Swap vK/vL
+                                        updateVK();
+
+                                        // Viterbi decoding.
+                                        viterbiDecode();
+
+                                        // Break search loop.
+                                        vKUpdated = true;
+                                        break;
+                                    }
+                                }
+                            } // if (!terminated[j])
+                        } // for (int j=0;j<vK.size(); ++j)
+                    } // if (parents[i] < 0)
+
+                    // Update inputCount for consequent none v* points.
+                    if(parents[i-nodeOffset]>=0 && inputCount == i)
+                    {
+                        // Update start point of DAG search.
+                        ++inputCount;
+
+                        // Adapt the threshold if layers grow long past the budget.
+                        if (budgetRatio > 0 && (inputCount-budgetWindowStart)*budgetRatio >= budgetWindow())
+                            adaptThreshold();
+                    }
+
+                    // Force a commit at i if the output lags too far behind.
+                    if (!vKUpdated && delayExceeded(simplifiedIndex.back(), i))
+                    {
+                        // Minimize ISSED.
+                        minimizeISSED();
+
+                        // Swap vK/vL
+                        if (!vL.empty())
+                        {
+                            updateVK();
+                            vKUpdated = true;
+                        }
+
+                        // Decide the path of the least ISSED within the delay.
+                        if (forceCommit(i))
+                            vKUpdated = true;
+
+                        // Viterbi decoding.
+                        viterbiDecode();
+                    }
+
+                    if (vKUpdated)
+                        break;
+                } // for (int i=inputCount; i<numPoints; ++i)
+
+                // Stop DAG search if no new vK generated.
+                if (!vKUpdated)
+                    break;
+            }
+        }
+    }
+
+    /**
+     * @brief getLSSD calculates the LSSD (logogram of Local integral Square Synchronous Euclidean Distance ) between
+     * two points indexed by fst and lst.
+     * @param fst is index of the first point.
+     * @param lst is index of the second point.
+     * @return the LSSD distance.
+     */
+    inline double getLSSD(int fst, int lst)
+    {
+        int dataOffset = rootSimplifier->dataOffset;
+        int pfst = position(fst)-dataOffset;
+        int plst = position(lst)-dataOffset;
+        if (pfst+1>=plst)
+            return 0;
+        // Only the level owning the statistics checks their count, as the root may append to them meanwhile when the
+        // cascade is pipelined.
+        assert(pfst>=0 && (pStatistics != &statistics || plst<pStatistics->count()));
+        DOTS_STATS_RECORD(++stats.lssdEvaluations);
+
+        return pStatistics->lssd(pfst, plst);
+    }
+
+    /**
+     * @brief loadFirstPoint gathers statistics of a point as the first point of a segment.
+     * @param node is index of the point.
+     * @param p receives the statistics.
+     */
+    inline void loadFirstPoint(int node, LssdPoint &p)
+    {
+        pStatistics->getFirstPoint(position(node)-rootSimplifier->dataOffset, p);
+    }
+
+    /**
+     * @brief loadLastPoint gathers statistics of a point as the last point of a segment.
+     * @param node is index of the point.
+     * @param p receives the statistics.
+     */
+    inline void loadLastPoint(int node, LssdPoint &p)
+    {
+        pStatistics->getLastPoint(position(node)-rootSimplifier->dataOffset, p);
+    }
+
+    /**
+     * @brief refreshFrontier gathers statistics of the Vk elements into the SoA frontier for batched LSSD evaluation.
+     */
+    inline void refreshFrontier()
+    {
+        int count = static_cast<int>(vK.size());
+        frontier.resize(count);
+        frontierLssd.resize(count);
+        LssdPoint p;
+        for (int k=0; k<count; ++k)
+        {
+            loadFirstPoint(vK[k], p);
+            frontier.set(k, p);
+        }
+        frontierGeneration = rootSimplifier->dataGeneration;
+
+        // LSSD kept for Vl elements was evaluated against the old frontier.
+        vLLssd.clear();
+        vLLssdCount.assign(vLLssdCount.size(), 0);
+    }
+
+    /**
+     * @brief evaluateFrontier calculates LSSD from Vk elements in range [begin, end) to the point indexed by lst. The
+     * results are stored in frontierLssd.
+     * @param lst is index of the last point.
+     * @param begin is the first Vk element to evaluate.
+     * @param end is one past the last Vk element to evaluate.
+     */
+    inline void evaluateFrontier(int lst, int begin, int end)
+    {
+        // Input data of the cascade root may have been rebased since the frontier was gathered.
+        if (frontierGeneration != rootSimplifier->dataGeneration)
+            refreshFrontier();
+
+        LssdPoint l;
+        loadLastPoint(lst, l);
+        LssdKernel::evaluate(frontier, begin, end, l, frontierLssd.data());
+        DOTS_STATS_RECORD(stats.lssdEvaluations += end-begin);
+    }
+
+    /**
+     * @brief appendVL appends a point to Vl, and keeps the LSSD the forward search evaluated for it, i.e. the blocks of
+     * the frontier up to the one holding its parent, for minimizeISSED().
+     * @param node is index of the point.
+     * @param parentPos is the position of its parent in Vk.
+     */
+    inline void appendVL(int node, int parentPos)
+    {
+        int evaluated = std::min((parentPos/LSSD_BLOCK_SIZE+1)*LSSD_BLOCK_SIZE, static_cast<int>(vK.size()));
+        vL.push_back(node);
+        vLLssdBegin.push_back(static_cast<int>(vLLssd.size()));
+        vLLssdCount.push_back(evaluated);
+        vLLssd.insert(vLLssd.end(), frontierLssd.begin(), frontierLssd.begin()+evaluated);
+    }
+
+    /**
+     * @brief needUpdateVK Checks if we need to swap Vl and Vk sets.
+     * @return true if a swap operation is necessary, false otherwise.
+     */
+    inline bool needUpdateVK()
+    {
+        return (static_cast<int>(vK.size()) == numTerminated || static_cast<int>(vL.size()) >= maxVkSize);
+    }
+
+    /**
+     * @brief updateVK swaps Vl and Vk sets and updates the DAG paths from root node to each elements of current Vk set.
+     *
+     * The DAG paths form a tree linked by parents. Each node of the tree counts its children that still have
+     * descendants in the current Vk set, so branches that die out are pruned in amortized O(1) per node.
+     */
+    inline void updateVK()
+    {
+        DOTS_STATS_RECORD(++stats.layers);
+        DOTS_STATS_RECORD(stats.vKSize.record(vK.size()));
+        DOTS_STATS_RECORD(stats.vLSize.record(vL.size()));
+        DOTS_STATS_RECORD(stats.pathTreeSteps += vL.size());
+
+        // Attach the new layer to the path tree.
+        for (size_t k=0; k<vL.size(); ++k)
+        {
+            int node = vL[k];
+            int parentPos = parents[node-nodeOffset]-nodeOffset;
+            ++liveChildren[parentPos];
+            liveChildXor[parentPos] ^= node;
+        }
+
+        // Prune the branches ending at Vk elements that got no children.
+        for (size_t m=0; m<vK.size(); ++m)
+        {
+            int node = vK[m];
+            while (liveChildren[node-nodeOffset] == 0)
+            {
+                int parentPos = parents[node-nodeOffset];
+                if (parentPos < 0)
+                    break;
+                --liveChildren[parentPos-nodeOffset];
+                liveChildXor[parentPos-nodeOffset] ^= node;
+                node = parentPos;
+                DOTS_STATS_RECORD(++stats.pathTreeSteps);
+            }
+        }
+
+        // Update vK set.
+        vK.swap(vL);
+        terminated.assign(vK.size(), false);
+        numTerminated = 0;
+        vL.clear();
+        vLLssd.clear();
+        vLLssdBegin.clear();
+        vLLssdCount.clear();
+        refreshFrontier();
+
+        // Count the layer for the output budget.
+        if (budgetRatio > 0)
+        {
+            ++budgetLayers;
+            if (++budgetWindowLayers >= budgetWindow())
+                adaptThreshold();
+        }
+    }
+
+    /**
+     * @brief budgetWindow retrieves the number of layers between two adaptations of the threshold in output budget
+     * mode. It is one during the first BUDGET_WINDOW layers, as a small budget may not allow many more, and
+     * BUDGET_WINDOW afterwards.
+     * @return the number of layers.
+     */
+    inline int budgetWindow() const
+    {
+        return budgetLayers < BUDGET_WINDOW ? 1 : BUDGET_WINDOW;
+    }
+
+    /**
+     * @brief adaptThreshold steers the LSSD threshold toward the output budget. It is called once every budgetWindow()
+     * layers, or once the inputs decided since the last call are as many as the budget allows for that many layers,
+     * which happens while the threshold is far too high to complete layers.
+     *
+     * During the first BUDGET_WINDOW layers the initial guess may be off by orders of magnitude, so the threshold is
+     * measured rather than stepped: the layers spent so far and BUDGET_HORIZON more should cover the inputs decided so
+     * far at the budget, which gives the span of the next layers, and the threshold is set to the LSSD of segments of
+     * that span around the decided inputs (see measureThreshold()). Afterwards, or if no such segment was fed yet, the
+     * threshold is scaled by a power of the ratio between the actual and the target output rates, where the actual
+     * rate is measured over the recent window and over all inputs decided so far. The latter removes the bias the
+     * window leaves behind, so that the total output count converges to the budget.
+     */
+    inline void adaptThreshold()
+    {
+        int windowInputs = inputCount-budgetWindowStart;
+        if (windowInputs <= 0 || inputCount <= 0)
+            return;
+
+        double threshold = 0;
+        if (budgetLayers < BUDGET_WINDOW)
+        {
+            double horizon = std::max<double>(BUDGET_HORIZON, budgetLayers);
+            double span = (budgetLayers+horizon-budgetRatio*inputCount)/(budgetRatio*horizon);
+            threshold = measureThreshold(std::min(std::max(span, 0.25/budgetRatio), 4/budgetRatio));
+        }
+        if (threshold > 0)
+        {
+            lssdTh = threshold;
+        }
+        else
+        {
+            // Count half a layer while the threshold is too high to complete any, to keep the rates positive.
+            double windowRate = std::max<double>(budgetWindowLayers, 0.5)/windowInputs;
+            double totalRate = std::max<double>(budgetLayers, 0.5)/inputCount;
+            double step = BUDGET_WINDOW_GAIN*std::log(windowRate/budgetRatio)
+                    + BUDGET_TOTAL_GAIN*std::log(totalRate/budgetRatio);
+            if (step > BUDGET_MAX_STEP)
+                step = BUDGET_MAX_STEP;
+            else if (step < -BUDGET_MAX_STEP)
+                step = -BUDGET_MAX_STEP;
+            lssdTh *= std::exp(step);
+        }
+        lssdUpperBound = lssdTh*lssdFactor;
+
+        budgetWindowLayers = 0;
+        budgetWindowStart = inputCount;
+    }
+
+    /**
+     * @brief measureThreshold measures the LSSD threshold that makes segments span a given number of nodes, as the
+     * geometric mean of LSSD of the segments of that span tiling the fed nodes within twice the span around the last
+     * decided one. While fewer nodes were fed, e.g. at the start of online feeding, LSSD of all of them is extrapolated
+     * to the span by a power of BUDGET_SPAN_EXPONENT.
+     * @param span is the number of nodes a segment should span.
+     * @return the threshold, or 0 if not enough nodes were fed yet.
+     */
+    inline double measureThreshold(double span)
+    {
+        int length = std::max(2, static_cast<int>(span+0.5));
+        int anchor = std::max(nodeOffset, inputCount-1);
+        int first = std::max(nodeOffset, anchor-2*length);
+        int last = std::min(nodeOffset+nodeCount()-1, anchor+2*length);
+        double logSum = 0;
+        int count = 0;
+        for (int fst=first; fst+length<=last; fst+=length)
+        {
+            double distance = getLSSD(fst, fst+length);
+            if (distance > 0)
+            {
+                logSum += std::log(distance);
+                ++count;
+            }
+        }
+        if (count > 0)
+            return std::exp(logSum/count);
+
+        // Extrapolate from the fed nodes.
+        if (last-first < BUDGET_MIN_SPAN)
+            return 0;
+        return getLSSD(first, last)*std::pow(static_cast<double>(length)/(last-first), BUDGET_SPAN_EXPONENT);
+    }
+
+    /**
+     * @brief delayExceeded checks if a point is further from an earlier one than the maximum delay allows.
+     * @param fst is index of the earlier point.
+     * @param lst is index of the point.
+     * @return true if the maximum delay is exceeded, false otherwise.
+     */
+    inline bool delayExceeded(int fst, int lst)
+    {
+        if (maxDelayPoints <= 0 && maxDelaySeconds <= 0)
+            return false;
+
+        int first = position(fst);
+        int last = position(lst);
+        if (maxDelayPoints > 0 && last-first > maxDelayPoints)
+            return true;
+        int dataOffset = rootSimplifier->dataOffset;
+        return maxDelaySeconds > 0
+                && pStatistics->t(last-dataOffset)-pStatistics->t(first-dataOffset) > maxDelaySeconds;
+    }
+
+    /**
+     * @brief forceCommit reduces the Vk set to a single element and prunes the DAG paths of the others, so that
+     * viterbiDecode() outputs the path to it. Vk elements are compared by the ISSED of the path through them to the
+     * point under evaluation, which covers the same points for all of them. The best element within the maximum delay
+     * from the point under evaluation is kept. If no element is within the delay, the point under evaluation is linked
+     * to the best element, even beyond the LSSD threshold, and becomes the only element instead. The points after the
+     * kept element are unlinked, so that the DAG search assigns them again from it.
+     * @param lst is index of the point under evaluation.
+     * @return true if the Vk set was reduced, false if no element is between the last output point and lst.
+     */
+    inline bool forceCommit(int lst)
+    {
+        if (frontierGeneration != rootSimplifier->dataGeneration)
+            refreshFrontier();
+        int count = static_cast<int>(vK.size());
+        evaluateFrontier(lst, 0, count);
+
+        // The best element within the delay, otherwise the best element at all.
+        int committed = simplifiedIndex.back();
+        int best = -1, bestWithin = -1;
+        double bestIssed = 0, bestWithinIssed = 0;
+        for (int m=0; m<count; ++m)
+        {
+            int node = vK[m];
+            if (node < committed || node > lst)
+                continue;
+            double total = issed[node-nodeOffset]+frontierLssd[m];
+            if (best < 0 || total < bestIssed)
+            {
+                best = node;
+                bestIssed = total;
+            }
+            if (node > committed && !delayExceeded(node, lst) && (bestWithin < 0 || total < bestWithinIssed))
+            {
+                bestWithin = node;
+                bestWithinIssed = total;
+            }
+        }
+        if (best < 0)
+            return false;
+        bool link = (bestWithin < 0);
+        if (!link)
+            best = bestWithin;
+
+        // Prune the paths of the other elements.
+        for (size_t m=0; m<vK.size(); ++m)
+        {
+            int node = vK[m];
+            while (node != best && liveChildren[node-nodeOffset] == 0)
+            {
+                int parentPos = parents[node-nodeOffset];
+                if (parentPos < 0)
+                    break;
+                --liveChildren[parentPos-nodeOffset];
+                liveChildXor[parentPos-nodeOffset] ^= node;
+                node = parentPos;
+            }
+        }
+
+        // Unlink the points after it, which are off the path now.
+        int numPoints = nodeOffset+nodeCount();
+        for (int node=best+1; node<numPoints; ++node)
+        {
+            parents[node-nodeOffset] = -1;
+            liveChildren[node-nodeOffset] = 0;
+            liveChildXor[node-nodeOffset] = 0;
+        }
+        if (link)
+        {
+            parents[lst-nodeOffset] = best;
+            issed[lst-nodeOffset] = bestIssed;
+            ++liveChildren[best-nodeOffset];
+            liveChildXor[best-nodeOffset] ^= lst;
+            best = lst;
+        }
+        inputCount = best+1;
+
+        vK.assign(1, best);
+        terminated.assign(1, false);
+        numTerminated = 0;
+        refreshFrontier();
+        ++forcedCommits;
+        return true;
+    }
+
+    /**
+     * @brief minimizeISSED minimizes the total error from root node to each element of Vl set. The minimization is
+     * done by choosing the best parents of Vl elements among Vk elements.
+     *
+     * Since LSSD is never negative, a Vk element whose ISSED alone exceeds the best total found so far could not be a
+     * better parent. Vk elements are therefore visited in ascending ISSED order until that happens, and LSSD is only
+     * evaluated for the visited ones, reusing what the forward search evaluated already. Ties are broken as the
+     * exhaustive search in Vk order would do: the current parent is kept, otherwise the first Vk element wins.
+     */
+    inline void minimizeISSED()
+    {
+        if (vL.empty())
+            return;
+        if (frontierGeneration != rootSimplifier->dataGeneration)
+            refreshFrontier();
+
+        // Sort Vk positions by ISSED, then by position.
+        int count = static_cast<int>(vK.size());
+        issedOrder.resize(count);
+        for (int m=0; m<count; ++m)
+            issedOrder[m] = m;
+        std::sort(issedOrder.begin(), issedOrder.end(), [this](int a, int b) {
+            double issedA = issed[vK[a]-nodeOffset], issedB = issed[vK[b]-nodeOffset];
+            return issedA < issedB || (issedA == issedB && a < b);
+        });
+
+        LssdPoint l;
+        for (size_t k=0; k<vL.size(); ++k)
+        {
+            int i = vL[k];
+            double minDistance = issed[i-nodeOffset];
+            int minParent = parents[i-nodeOffset];
+            int minPos = -1;
+            const double *cached = vLLssdCount[k] > 0 ? &vLLssd[vLLssdBegin[k]] : NULL;
+            bool loaded = false;
+            for (int r=0; r<count; ++r) {
+                int m = issedOrder[r];
+                int j = vK[m];
+                if (issed[j-nodeOffset] > minDistance)
+                    break;
+                DOTS_STATS_RECORD(++stats.issedIterations);
+
+                double localDistance;
+                if (m < vLLssdCount[k])
+                {
+                    localDistance = cached[m];
+                }
+                else
+                {
+                    if (!loaded)
+                    {
+                        loadLastPoint(i, l);
+                        loaded = true;
+                    }
+                    localDistance = LssdKernel::lssd(frontier.get(m), l);
+                    DOTS_STATS_RECORD(++stats.lssdEvaluations);
+                }
+                double distance = issed[j-nodeOffset] + localDistance;
+                if (localDistance<lssdTh && (distance<minDistance || (distance == minDistance && m < minPos)))
+                {
+                    minDistance = distance;
+                    minParent = j;
+                    minPos = m;
+                }
+            }
+            issed[i-nodeOffset] = minDistance;
+            parents[i-nodeOffset] = minParent;
+        }
+    }
+
+    /**
+     * @brief viterbiDecode decodes output indices of simplified points in a viterbi-like manner. All DAG paths share
+     * the next point as long as the last decoded point has exactly one live child in the path tree.
+     */
+    inline void viterbiDecode()
+    {
+        int node = simplifiedIndex.back();
+        while (liveChildren[node-nodeOffset] == 1)
+        {
+            // The XOR of a single child is the child itself.
+            node = liveChildXor[node-nodeOffset];
+            simplifiedIndex.push_back(node);
+        }
+    }
+
+    /**
+     * @brief compactCommittedPrefix drops the committed prefix from internal containers in streaming mode and rebases
+     * the prefix sums at the current commit point. The work is amortized by compacting only when the droppable prefix
+     * outgrows the retained window.
+     */
+    void compactCommittedPrefix()
+    {
+        if (simplifiedIndex.empty())
+            return;
+
+        // The last committed point anchors both the DAG search and the viterbi decoding, so it is always retained.
+        // Committed points that were not read yet are retained as well.
+        int keepOutput = std::min(outputCount, outputOffset+outputSize()-1);
+        int keepNode = simplifiedIndex[keepOutput-outputOffset];
+
+        // The live part of the DAG may reach before the commit point (see firstLiveNode()). Look for it only if the
+        // commit point itself would allow dropping nodes or input data, as this walks the whole window.
+        int dropBound = keepNode-nodeOffset;
+        int dropDataBound = isCascadeRoot ? keepNode-dataOffset : 0;
+        if ((dropBound >= STREAMING_COMPACT_MIN && dropBound >= nodeCount()-dropBound)
+                || (dropDataBound >= STREAMING_COMPACT_MIN && dropDataBound >= statistics.count()-dropDataBound))
+            keepNode = firstLiveNode(keepNode);
+
+        // Drop the committed outputs.
+        int dropOutputs = keepOutput-outputOffset;
+        if (dropOutputs >= STREAMING_COMPACT_MIN && dropOutputs >= outputSize()-dropOutputs)
+        {
+            simplifiedIndex.erase(simplifiedIndex.begin(), simplifiedIndex.begin()+dropOutputs);
+            outputOffset += dropOutputs;
+        }
+
+        // Drop nodes before the commit point and rebase ISSED there.
+        int dropNodes = keepNode-nodeOffset;
+        if (dropNodes >= STREAMING_COMPACT_MIN && dropNodes >= nodeCount()-dropNodes)
+        {
+            if (!isCascadeRoot)
+                ptIndex.erase(ptIndex.begin(), ptIndex.begin()+dropNodes);
+            issed.erase(issed.begin(), issed.begin()+dropNodes);
+            parents.erase(parents.begin(), parents.begin()+dropNodes);
+            liveChildren.erase(liveChildren.begin(), liveChildren.begin()+dropNodes);
+            liveChildXor.erase(liveChildXor.begin(), liveChildXor.begin()+dropNodes);
+            nodeOffset += dropNodes;
+
+            double base = issed[0];
+            for (size_t k=0; k<issed.size(); ++k)
+            {
+                if (parents[k] >= 0)
+                    issed[k] -= base;
+            }
+            issedOffset += base;
+        }
+
+        // Drop input data that neither this simplifier nor any cascade level would touch again.
+        if (!isCascadeRoot)
+            return;
+        int keepData = keepNode;
+        for (size_t k=0; k<cascadeChildren.size(); ++k)
+        {
+            const DotsCoreT *child = cascadeChildren[k];
+            if (!child->ptIndex.empty() && child->ptIndex[0] < keepData)
+                keepData = child->ptIndex[0];
+        }
+        // A point evaluated as the last point of a segment reads the prefix sums of the preceding point.
+        int dropData = keepData-1-dataOffset;
+        if (dropData >= STREAMING_COMPACT_MIN && dropData >= statistics.count()-dropData)
+        {
+            statistics.removeFirst(dropData);
+            dataOffset += dropData;
+            ++dataGeneration;
+        }
+    }
+
+    /**
+     * @brief liveWindow finds the part of the containers a snapshot has to hold. It starts at the last committed output
+     * that was read, which anchors the DAG search, and at the first node that may still be touched.
+     * @param firstNode receives index of the first live node.
+     * @param firstOutput receives the position of the first live output.
+     */
+    void liveWindow(int &firstNode, int &firstOutput) const
+    {
+        firstNode = nodeOffset;
+        firstOutput = outputOffset;
+        if (simplifiedIndex.empty())
+            return;
+
+        firstOutput = std::min(outputCount, outputOffset+outputSize()-1);
+        firstNode = firstLiveNode(simplifiedIndex[firstOutput-outputOffset]);
+    }
+
+    /**
+     * @brief saveLevel writes the settings and the live window of this simplifier.
+     * @param writer is the writer.
+     * @param firstNode is index of the first node to write.
+     * @param firstOutput is the position of the first output to write.
+     */
+    void saveLevel(BinaryWriter &writer, int firstNode, int firstOutput) const
+    {
+        writer.write(lssdTh);
+        writer.write(lssdFactor);
+        writer.write(lssdUpperBound);
+        writer.write(maxVkSize);
+        writer.write(budgetRatio);
+        writer.write(maxDelayPoints);
+        writer.write(maxDelaySeconds);
+        writer.write(forcedCommits);
+        writer.write(budgetLayers);
+        writer.write(budgetWindowLayers);
+        writer.write(budgetWindowStart);
+        writer.write(static_cast<char>(streaming));
+        writer.write(static_cast<char>(finished));
+        writer.write(inputCount);
+        writer.write(outputCount);
+        writer.write(numTerminated);
+        writer.write(issedOffset);
+
+        int first = firstNode-nodeOffset;
+        writer.write(firstNode);
+        writer.writeArray(ptIndex.data()+(isCascadeRoot ? 0 : first), isCascadeRoot ? 0 : nodeCount()-first);
+        writer.writeArray(issed.data()+first, nodeCount()-first);
+        writer.writeArray(parents.data()+first, nodeCount()-first);
+        writer.writeArray(liveChildren.data()+first, nodeCount()-first);
+        writer.writeArray(liveChildXor.data()+first, nodeCount()-first);
+        writer.writeArray(vK.data(), static_cast<int>(vK.size()));
+        writer.writeArray(vL.data(), static_cast<int>(vL.size()));
+        writer.writeArray(terminated.data(), static_cast<int>(terminated.size()));
+
+        writer.write(firstOutput);
+        writer.writeArray(simplifiedIndex.data()+firstOutput-outputOffset, outputOffset+outputSize()-firstOutput);
+    }
+
+    /**
+     * @brief loadLevel replaces the settings and the state of this simplifier by what saveLevel() wrote.
+     * @param reader is the reader.
+     */
+    void loadLevel(BinaryReader &reader)
+    {
+        lssdTh = reader.read<double>();
+        lssdFactor = reader.read<double>();
+        lssdUpperBound = reader.read<double>();
+        maxVkSize = reader.read<int>();
+        budgetRatio = reader.read<double>();
+        maxDelayPoints = reader.read<int>();
+        maxDelaySeconds = reader.read<double>();
+        forcedCommits = reader.read<int>();
+        budgetLayers = reader.read<int>();
+        budgetWindowLayers = reader.read<int>();
+        budgetWindowStart = reader.read<int>();
+        streaming = (reader.read<char>() != 0);
+        finished = (reader.read<char>() != 0);
+        inputCount = reader.read<int>();
+        outputCount = reader.read<int>();
+        numTerminated = reader.read<int>();
+        issedOffset = reader.read<double>();
+
+        nodeOffset = reader.read<int>();
+        reader.readArray(ptIndex);
+        reader.readArray(issed);
+        reader.readArray(parents);
+        reader.readArray(liveChildren);
+        reader.readArray(liveChildXor);
+        reader.readArray(vK);
+        reader.readArray(vL);
+        reader.readArray(terminated);
+        if (ptIndex.size() != (isCascadeRoot ? 0 : issed.size()) || parents.size() != issed.size()
+                || liveChildren.size() != issed.size() || liveChildXor.size() != issed.size()
+                || terminated.size() != vK.size())
+            throw std::runtime_error("Corrupted or truncated binary data.");
+
+        outputOffset = reader.read<int>();
+        reader.readArray(simplifiedIndex);
+
+        // The frontier is gathered again by the next evaluation, and LSSD of Vl elements is evaluated again.
+        frontier.resize(0);
+        frontierLssd.clear();
+        frontierGeneration = -1;
+        vLLssd.clear();
+        vLLssdBegin.assign(vL.size(), 0);
+        vLLssdCount.assign(vL.size(), 0);
+    }
+
+    /**
+     * @brief firstLiveNode finds the first node that the DAG search or decoding may still touch. A point that got no
+     * parent before all Vk elements terminated joins a later layer, so it may be linked to a parent with a greater
+     * index, and the live part of the DAG may start before the commit point.
+     * @param commitNode is the last committed node.
+     * @return index of the first live node.
+     */
+    int firstLiveNode(int commitNode) const
+    {
+        // Points not assigned yet.
+        int first = commitNode;
+        if (inputCount < first)
+            first = inputCount;
+
+        // Vl elements and Vk elements together with their ancestors down from the commit point.
+        std::vector<bool> visited(nodeCount(), false);
+        for (size_t k=0; k<vL.size(); ++k)
+        {
+            if (vL[k] < first)
+                first = vL[k];
+        }
+        for (size_t k=0; k<vK.size(); ++k)
+        {
+            int node = vK[k];
+            while (node >= nodeOffset && node != commitNode && !visited[node-nodeOffset])
+            {
+                visited[node-nodeOffset] = true;
+                if (node < first)
+                    first = node;
+                node = parents[node-nodeOffset];
+            }
+        }
+        return first;
+    }
+
+protected:
+    // DOTS settings.
+    /**
+     * @brief lssdTh
+     */
+    double lssdTh;
+    double lssdFactor;
+    double lssdUpperBound;
+    int maxVkSize;
+
+    // Output budget mode: the target ratio of outputs to inputs (0 if disabled), the number of layers so far, and the
+    // layers and the first input of the current adaptation window.
+    double budgetRatio;
+    int budgetLayers;
+    int budgetWindowLayers;
+    int budgetWindowStart;
+
+    // Hot-path statistics, collected if DOTS_STATS is defined.
+    DotsStats stats;
+
+    // Maximum output delay in input points and in seconds (0 if not bounded), and the number of commits it forced.
+    int maxDelayPoints;
+    double maxDelaySeconds;
+    int forcedCommits;
+
+    // Input sequence and its prefix statistics.
+    PrefixStatistics statistics;
+    PrefixStatistics *pStatistics;
+    // Positions of the nodes in the input data of the cascade root. The root leaves it empty, see position().
+    std::vector<int> ptIndex;
+
+    // Streaming mode. Offsets are the logical indices of the first elements retained by the containers, i.e. the
+    // number of elements dropped from the front: dataOffset for the prefix statistics, nodeOffset for
+    // ptIndex/issed/parents/liveChildren/liveChildXor and outputOffset for simplifiedIndex.
+    bool streaming;
+    int dataOffset;
+    int nodeOffset;
+    int outputOffset;
+    double issedOffset;
+    DotsCoreT *rootSimplifier;
+    std::vector<DotsCoreT *> cascadeChildren;
+
+    // DOTS algorithm internal data.
+    std::vector<int> vK,vL;
+    std::vector<char> terminated;
+    int numTerminated;
+
+    // Statistics of Vk elements in SoA layout, LSSD of them to the point under evaluation, and the generation of the
+    // input data they were gathered from.
+    LssdFrontier frontier;
+    std::vector<double> frontierLssd;
+    int frontierGeneration;
+    int dataGeneration;
+    // LSSD of vL[k] to the Vk elements at frontier positions [0, vLLssdCount[k]) as evaluated by the forward search,
+    // stored from vLLssd[vLLssdBegin[k]], and Vk positions in ascending ISSED order, both used by minimizeISSED().
+    std::vector<double> vLLssd;
+    std::vector<int> vLLssdBegin;
+    std::vector<int> vLLssdCount;
+    std::vector<int> issedOrder;
+    std::vector<double> issed;
+    std::vector<int> parents;
+    // Path tree: number of children having descendants in Vk, and XOR of their indices.
+    std::vector<int> liveChildren;
+    std::vector<int> liveChildXor;
+
+    // Output sequence.
+    std::vector<int> simplifiedIndex;
+    int inputCount;
+    int outputCount;
+
+    // Indicates if the input got EOF. No more data could be input after this flag was set.
+    bool finished;
+
+    bool isCascadeRoot;
+
+    /**
+     * @brief STREAMING_COMPACT_MIN is the minimum number of droppable elements before a compaction is done.
+     */
+    static const int STREAMING_COMPACT_MIN = 256;
+
+    /**
+     * @brief BUDGET_WINDOW is the number of DAG layers between two adaptations of the threshold in output budget mode.
+     */
+    static const int BUDGET_WINDOW = 8;
+
+    /**
+     * @brief BUDGET_HORIZON is the minimum number of layers over which the first adaptations spread the deviation from
+     * the output budget.
+     */
+    static const int BUDGET_HORIZON = 4;
+
+    /**
+     * @brief BUDGET_MIN_SPAN is the minimum number of nodes measureThreshold() extrapolates from, and
+     * BUDGET_SPAN_EXPONENT is the power LSSD is assumed to grow by with the span, as measured on GPS tracks.
+     */
+    static const int BUDGET_MIN_SPAN = 4;
+    static constexpr double BUDGET_SPAN_EXPONENT = 3.0;
+
+    /**
+     * @brief BUDGET_WINDOW_GAIN and BUDGET_TOTAL_GAIN are the exponents applied to the window and total rate ratios,
+     * and BUDGET_MAX_STEP bounds the logarithm of a single adaptation.
+     */
+    static constexpr double BUDGET_WINDOW_GAIN = 1.0;
+    static constexpr double BUDGET_TOTAL_GAIN = 1.0;
+    static constexpr double BUDGET_MAX_STEP = 1.4;
+
+    /**
+     * @brief SNAPSHOT_MAGIC and SNAPSHOT_VERSION head every snapshot written by saveState().
+     */
+    static const int SNAPSHOT_MAGIC = 0x53544f44;
+    static const int SNAPSHOT_VERSION = 4;
+
+    /**
+     * @brief LSSD_BLOCK_SIZE is the number of Vk elements evaluated at a time by the forward DAG search.
+     */
+    static const int LSSD_BLOCK_SIZE = 16;
+};
+
+/**
+ * @brief DotsCore is the 2D double instantiation, and DotsCore3D the 3D one, e.g. for projected positions with
+ * altitude.
+ */
+typedef DotsCoreT<2, double> DotsCore;
+typedef DotsCoreT<3, double> DotsCore3D;
+
+#endif // DOTSCORE_H
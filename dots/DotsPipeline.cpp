@@ -0,0 +1,139 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+#include "DotsPipeline.h"
+#include"DotsException.h"
+
+DotsPipeline::DotsPipeline(QObject *parent) : QObject(parent)
+{
+    simplifier.setStreamingMode(true);
+    scaleFactor = 0;
+    pointCount = 0;
+    finished = true;
+    outputPending = false;
+}
+
+void DotsPipeline::setParameters(double lssdTh, double k, int maxVkSize)
+{
+    simplifier.setParameters(lssdTh, k, maxVkSize);
+}
+
+void DotsPipeline::setMaxDelay(int maxPoints, double maxSeconds)
+{
+    simplifier.setMaxDelay(maxPoints, maxSeconds);
+}
+
+void DotsPipeline::setScaleFactor(double scaleFactor)
+{
+    if (scaleFactor < 0)
+        DotsException("The scale factor must not be negative.").raise();
+    this->scaleFactor = scaleFactor;
+}
+
+void DotsPipeline::open(QString fileName)
+{
+    Helper::checkNotNullNorEmpty("fileName", fileName);
+    if (fileName.endsWith(Helper::BINARY_SUFFIX))
+        DotsException("Binary trajectory files are not streamed. Try Helper::parseBinary() instead.").raise();
+
+    close();
+    reader.reset(new TrajectoryReader(fileName, TrajectoryReader::formatOf(fileName)));
+    simplifier.resetInternalData();
+    frame = TrajectoryFrame();
+    pointCount = 0;
+    finished = false;
+    outputPending = false;
+}
+
+bool DotsPipeline::readOutputIndex(int &index)
+{
+    if (reader.isNull())
+        DotsException("No trajectory file is open.").raise();
+
+    // Points decided together are output one by one before the next record is fed.
+    if (outputPending)
+    {
+        outputPending = simplifier.readOutputIndex(index);
+        if (outputPending)
+            return true;
+    }
+
+    // Feed one record at a time, as DotsSimplifier::batchDotsByIndex() does.
+    while (!finished)
+    {
+        if (!feedNextRecord())
+        {
+            simplifier.finish();
+            finished = true;
+            break;
+        }
+        if (simplifier.readOutputIndex(index))
+        {
+            outputPending = true;
+            return true;
+        }
+    }
+    return simplifier.readOutputIndex(index);
+}
+
+void DotsPipeline::close()
+{
+    reader.reset();
+    finished = true;
+    outputPending = false;
+}
+
+int DotsPipeline::getPointCount() const
+{
+    return pointCount;
+}
+
+TrajectoryFrame DotsPipeline::getFrame() const
+{
+    return frame;
+}
+
+void DotsPipeline::streamDotsByIndex(QString fileName, QVector<int> &simplifiedIndex, double lssdThreshold,
+                                     double scaleFactor, TrajectoryFrame *frame)
+{
+    DotsPipeline pipeline;
+    pipeline.setParameters(lssdThreshold);
+    pipeline.setScaleFactor(scaleFactor);
+    pipeline.open(fileName);
+
+    simplifiedIndex.clear();
+    int index;
+    while (pipeline.readOutputIndex(index))
+        simplifiedIndex.append(index);
+    if (frame != NULL)
+        *frame = pipeline.getFrame();
+}
+
+bool DotsPipeline::feedNextRecord()
+{
+    TrajectoryRecord record;
+    if (!reader->next(record))
+        return false;
+
+    // The first record fixes the projection and the offsets.
+    bool geographic = reader->isGeographic();
+    if (pointCount == 0)
+    {
+        frame = TrajectoryFrame(0, record.x, record.y, record.t);
+        if (geographic)
+        {
+            frame.scaleFactor = (scaleFactor > 0) ? scaleFactor : Helper::mercatorScaleFactor(&record.y, 1);
+            Helper::mercatorProjectPoint(record.x, record.y, frame.scaleFactor, frame.offsetX, frame.offsetY);
+        }
+    }
+
+    double x = record.x, y = record.y;
+    if (geographic)
+        Helper::mercatorProjectPoint(record.x, record.y, frame.scaleFactor, x, y);
+    simplifier.feedData(x-frame.offsetX, y-frame.offsetY, record.t-frame.offsetT);
+    ++pointCount;
+    return true;
+}
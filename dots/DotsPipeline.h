@@ -0,0 +1,132 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief DotsPipeline.h defines the DotsPipeline class.
+  * @author caoweiquan322
+  */
+#ifndef DOTSPIPELINE_H
+#define DOTSPIPELINE_H
+
+#include <QObject>
+#include<QScopedPointer>
+#include<QString>
+#include<QVector>
+#include"DotsSimplifier.h"
+#include"Helper.h"
+#include"TrajectoryReader.h"
+
+/**
+ * @brief The DotsPipeline class streams a trajectory text file through DOTS without materializing the file. Records
+ * are read one by one, projected, re-centred on the first point and fed to a simplifier in streaming mode, so the
+ * memory of a pipeline is bounded by the decision window of DOTS rather than the length of the file, and the first
+ * output is available as soon as DOTS commits it.
+ *
+ * Helper's parsers project by the mean scale factor of all points and normalize by the mean position, which takes
+ * the whole file. A pipeline instead projects by the scale factor of the first point, or a configured one, and
+ * subtracts the first point. Output indices are the positions of the selected records in the file, the same as the
+ * indices of the points Helper's parsers return.
+ */
+class DotsPipeline : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief DotsPipeline constructs a pipeline with no file open.
+     * @param parent is the parent of this QObject.
+     */
+    explicit DotsPipeline(QObject *parent = 0);
+
+    /**
+     * @brief setParameters sets the parameters of the simplifier. See DotsSimplifier::setParameters().
+     */
+    void setParameters(double lssdTh, double k = 2.0, int maxVkSize = 1e6);
+
+    /**
+     * @brief setMaxDelay bounds the output delay of the simplifier. See DotsSimplifier::setMaxDelay().
+     */
+    void setMaxDelay(int maxPoints, double maxSeconds = 0);
+
+    /**
+     * @brief setScaleFactor configures the scale factor of the mercator projection of files opened later.
+     * @param scaleFactor is the scale factor, or 0 (DEFAULT) to derive it from the latitude of the first point.
+     */
+    void setScaleFactor(double scaleFactor);
+
+    /**
+     * @brief open opens a trajectory text file, whose format is chosen by TrajectoryReader::formatOf(), and resets
+     * the simplifier. A file opened before is closed.
+     * @param fileName is the file name.
+     */
+    void open(QString fileName);
+
+    /**
+     * @brief readOutputIndex feeds records of the file to DOTS until it outputs a point, or until the end of the
+     * file, where the simplifier is finished and the remaining points are output.
+     * @param index receives the index of the selected record.
+     * @return true if a point was output, false if the file is completely simplified.
+     */
+    bool readOutputIndex(int &index);
+
+    /**
+     * @brief close closes the file. Points not read yet are dropped.
+     */
+    void close();
+
+    /**
+     * @brief getPointCount retrieves the number of records fed to DOTS so far.
+     * @return the number of records.
+     */
+    int getPointCount() const;
+
+    /**
+     * @brief getFrame retrieves the projection and the offsets of the points fed to DOTS, which are known once the
+     * first record was read.
+     * @return the frame.
+     */
+    TrajectoryFrame getFrame() const;
+
+    /**
+     * @brief streamDotsByIndex simplifies a trajectory text file by a pipeline and retrieves indices of the
+     * simplified points.
+     * @param fileName is the file name.
+     * @param simplifiedIndex receives the indices.
+     * @param lssdThreshold is the LSSD threshold.
+     * @param scaleFactor is the scale factor of the projection, or 0 to derive it from the first point.
+     * @param frame receives the projection and the offsets of the points, unless it is NULL.
+     */
+    static void streamDotsByIndex(QString fileName, QVector<int> &simplifiedIndex, double lssdThreshold,
+                                  double scaleFactor = 0, TrajectoryFrame *frame = NULL);
+
+protected:
+    /**
+     * @brief feedNextRecord reads, projects and re-centres the next record and feeds it to the simplifier.
+     * @return true if a record was fed, false at the end of the file.
+     */
+    bool feedNextRecord();
+
+    // The simplifier and the open file.
+    DotsSimplifier simplifier;
+    QScopedPointer<TrajectoryReader> reader;
+
+    // The configured scale factor, or 0 to derive it from the first point.
+    double scaleFactor;
+    // The projection and offsets of the open file.
+    TrajectoryFrame frame;
+    // The number of records fed so far.
+    int pointCount;
+    // Whether the end of the file was reached, and whether the last read returned a point, after which more points
+    // may be output without feeding another record.
+    bool finished;
+    bool outputPending;
+
+signals:
+
+public slots:
+};
+
+#endif // DOTSPIPELINE_H
@@ -0,0 +1,183 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+#include "DotsSessionManager.h"
+#include"DotsException.h"
+
+DotsSessionManager::DotsSessionManager(QObject *parent) : QObject(parent)
+{
+    lssdTh = 10000.0;
+    k = 2.0;
+    maxVkSize = 1e6;
+    maxDelayPoints = 0;
+    maxDelaySeconds = 0;
+    freeHead = -1;
+    activeHead = -1;
+    activeTail = -1;
+    lastId = 0;
+    lastSlot = -1;
+}
+
+void DotsSessionManager::setParameters(double lssdTh, double k, int maxVkSize)
+{
+    this->lssdTh = lssdTh;
+    this->k = k;
+    this->maxVkSize = maxVkSize;
+}
+
+void DotsSessionManager::setMaxDelay(int maxPoints, double maxSeconds)
+{
+    if (maxPoints < 0 || maxSeconds < 0)
+        DotsException("The maximum delay must not be negative.").raise();
+    maxDelayPoints = maxPoints;
+    maxDelaySeconds = maxSeconds;
+}
+
+void DotsSessionManager::feedData(qint64 id, double x, double y, double t)
+{
+    int slot = findSession(id);
+    if (slot < 0)
+        slot = openSession(id);
+
+    // Open sessions are never finished, so the point is fed unchecked.
+    Session &s = sessions[slot];
+    s.simplifier.feedDataUnchecked(x, y, t);
+    s.lastTime = t;
+
+    // Move the session to the tail of the activity list.
+    if (activeTail != slot)
+    {
+        unlink(slot);
+        linkLast(slot);
+    }
+}
+
+bool DotsSessionManager::readOutputIndex(qint64 id, int &index)
+{
+    int slot = findSession(id);
+    if (slot < 0)
+        return false;
+
+    return sessions[slot].simplifier.readOutputIndex(index);
+}
+
+void DotsSessionManager::closeSession(qint64 id, QVector<int> &remainingIndex)
+{
+    int slot = findSession(id);
+    if (slot < 0)
+        DotsException(QString("Stream %1 has no open session.").arg(id)).raise();
+
+    releaseSession(slot, remainingIndex);
+}
+
+int DotsSessionManager::expireIdleSessions(double now, double idleTimeout, QVector<qint64> &expiredIds,
+                                           QVector<QVector<int> > &remainingIndex)
+{
+    expiredIds.clear();
+    remainingIndex.clear();
+    while (activeHead >= 0 && sessions[activeHead].lastTime < now-idleTimeout)
+    {
+        expiredIds.append(sessions[activeHead].id);
+        remainingIndex.append(QVector<int>());
+        releaseSession(activeHead, remainingIndex.last());
+    }
+    return expiredIds.count();
+}
+
+bool DotsSessionManager::hasSession(qint64 id) const
+{
+    return sessionIndex.contains(id);
+}
+
+int DotsSessionManager::sessionCount() const
+{
+    return sessionIndex.count();
+}
+
+void DotsSessionManager::reserve(int n)
+{
+    sessionIndex.reserve(n);
+    sessions.reserve(n);
+    while (static_cast<int>(sessions.size()) < n)
+        appendFreeSlot();
+}
+
+int DotsSessionManager::openSession(qint64 id)
+{
+    if (freeHead < 0)
+        appendFreeSlot();
+
+    int slot = freeHead;
+    Session &s = sessions[slot];
+    freeHead = s.next;
+    s.simplifier.setParameters(lssdTh, k, maxVkSize);
+    s.simplifier.setMaxDelay(maxDelayPoints, maxDelaySeconds);
+    s.id = id;
+    s.lastTime = 0;
+    s.prev = s.next = -1;
+    linkLast(slot);
+    sessionIndex.insert(id, slot);
+    return slot;
+}
+
+void DotsSessionManager::releaseSession(int slot, QVector<int> &remainingIndex)
+{
+    Session &s = sessions[slot];
+
+    // Flush the outputs that were not read yet.
+    remainingIndex.clear();
+    s.simplifier.finish();
+    int index = -1;
+    while (s.simplifier.readOutputIndex(index))
+        remainingIndex.append(index);
+    s.simplifier.resetInternalData();
+
+    // Return the slot to the free list.
+    unlink(slot);
+    sessionIndex.remove(s.id);
+    s.next = freeHead;
+    freeHead = slot;
+    if (lastSlot == slot)
+        lastSlot = -1;
+}
+
+void DotsSessionManager::appendFreeSlot()
+{
+    sessions.push_back(Session());
+    Session &s = sessions.back();
+    s.simplifier.setStreamingMode(true);
+    s.id = 0;
+    s.lastTime = 0;
+    s.prev = -1;
+    s.next = freeHead;
+    freeHead = static_cast<int>(sessions.size())-1;
+}
+
+void DotsSessionManager::unlink(int slot)
+{
+    Session &s = sessions[slot];
+    if (s.prev >= 0)
+        sessions[s.prev].next = s.next;
+    else if (activeHead == slot)
+        activeHead = s.next;
+    if (s.next >= 0)
+        sessions[s.next].prev = s.prev;
+    else if (activeTail == slot)
+        activeTail = s.prev;
+    s.prev = s.next = -1;
+}
+
+void DotsSessionManager::linkLast(int slot)
+{
+    Session &s = sessions[slot];
+    s.prev = activeTail;
+    s.next = -1;
+    if (activeTail >= 0)
+        sessions[activeTail].next = slot;
+    else
+        activeHead = slot;
+    activeTail = slot;
+}
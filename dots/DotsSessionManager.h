@@ -0,0 +1,207 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief DotsSessionManager.h defines the DotsSessionManager class.
+  * @author caoweiquan322
+  */
+#ifndef DOTSSESSIONMANAGER_H
+#define DOTSSESSIONMANAGER_H
+
+#include <QObject>
+#include<QHash>
+#include<QVector>
+#include<vector>
+#include"DotsCore.h"
+
+/**
+ * @brief The DotsSessionManager class runs many interleaved trajectory streams through DOTS, one session per stream.
+ *
+ * Records (id, x, y, t) are routed by stream id to the session of that stream, which is opened by the first record of
+ * the stream. Every session runs its simplifier in streaming mode, so the memory of a session is bounded by its
+ * decision window rather than the length of its stream. Sessions live in a slot array indexed by a hash of stream
+ * ids and hold their DotsCore by value. Closed sessions return their slot to a free list, so opening a session reuses
+ * the containers of an earlier one instead of allocating new ones.
+ *
+ * Output indices are the positions of the selected points within their own stream, i.e. 0 for the first record of a
+ * stream. Like DotsCore, the DAG search runs when outputs are read, so readOutputIndex() should be called until
+ * it returns false after feeding each record.
+ */
+class DotsSessionManager : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief DotsSessionManager is the default constructor.
+     * @param parent is the QT parent object.
+     */
+    explicit DotsSessionManager(QObject *parent = 0);
+
+    /**
+     * @brief setParameters specifies DOTS settings of the sessions opened afterwards.
+     * @param lssdTh is the LSSD threshold for DAG searching.
+     * @param k is the factor for upper bound. LSSD that exceeds lssdTh*k would be ignored by DAG searching.
+     * @param maxVkSize is the maximum size of each layer of DAG tree.
+     */
+    void setParameters(double lssdTh, double k = 2.0, int maxVkSize = 1e6);
+
+    /**
+     * @brief setMaxDelay bounds the output latency of the sessions opened afterwards. See DotsCore::setMaxDelay().
+     * @param maxPoints is the maximum number of records between the last decided record and the newest one of a
+     * stream, or 0 for no bound.
+     * @param maxSeconds is the maximum time between the last decided record and the newest one of a stream, or 0 for
+     * no bound.
+     */
+    void setMaxDelay(int maxPoints, double maxSeconds = 0);
+
+    /**
+     * @brief feedData routes a 2D spatio temporary point to the session of a stream, and opens the session if the
+     * stream has none.
+     * @param id is the stream id.
+     * @param x is the x position.
+     * @param y is the y position.
+     * @param t is the timestamp.
+     */
+    void feedData(qint64 id, double x, double y, double t);
+
+    /**
+     * @brief readOutputIndex checks if the session of a stream outputs any data after the recent feeds.
+     * @param id is the stream id.
+     * @param index the selected index to output.
+     * @return true if there's output data, false otherwise or if the stream has no session.
+     */
+    bool readOutputIndex(qint64 id, int &index);
+
+    /**
+     * @brief closeSession finishes the session of a stream and releases it to the pool.
+     * @param id is the stream id.
+     * @param remainingIndex receives the output indices that were not read yet.
+     */
+    void closeSession(qint64 id, QVector<int> &remainingIndex);
+
+    /**
+     * @brief expireIdleSessions closes the sessions whose last timestamp is older than now-idleTimeout. Sessions are
+     * checked in the order they were last fed, and checking stops at the first session that is not idle, so the cost
+     * is proportional to the number of expired sessions. This assumes the streams share a clock.
+     * @param now is the current timestamp.
+     * @param idleTimeout is the maximum idle duration of a session.
+     * @param expiredIds receives ids of the expired streams.
+     * @param remainingIndex receives the unread output indices of each expired stream.
+     * @return the number of expired sessions.
+     */
+    int expireIdleSessions(double now, double idleTimeout, QVector<qint64> &expiredIds,
+                           QVector<QVector<int> > &remainingIndex);
+
+    /**
+     * @brief hasSession checks if a stream has an open session.
+     * @param id is the stream id.
+     * @return true if the stream has an open session, false otherwise.
+     */
+    bool hasSession(qint64 id) const;
+
+    /**
+     * @brief sessionCount retrieves the number of open sessions.
+     * @return the number of open sessions.
+     */
+    int sessionCount() const;
+
+    /**
+     * @brief reserve preallocates slots for n sessions, so that opening up to n sessions does not grow the slot array.
+     * @param n is the number of sessions.
+     */
+    void reserve(int n);
+
+protected:
+    /**
+     * @brief openSession takes a slot from the free list, or appends one, and binds it to a stream.
+     * @param id is the stream id.
+     * @return the slot.
+     */
+    int openSession(qint64 id);
+
+    /**
+     * @brief releaseSession finishes the simplifier of a slot, collects its unread outputs and returns the slot to the
+     * free list.
+     * @param slot is the slot.
+     * @param remainingIndex receives the output indices that were not read yet.
+     */
+    void releaseSession(int slot, QVector<int> &remainingIndex);
+
+    /**
+     * @brief findSession looks up the slot of a stream.
+     * @param id is the stream id.
+     * @return the slot, or -1 if the stream has no session.
+     */
+    inline int findSession(qint64 id)
+    {
+        // Records of a stream usually come in bursts, and reads follow feeds of the same stream.
+        if (lastSlot >= 0 && lastId == id)
+            return lastSlot;
+
+        QHash<qint64, int>::const_iterator it = sessionIndex.constFind(id);
+        if (it == sessionIndex.constEnd())
+            return -1;
+        lastId = id;
+        lastSlot = it.value();
+        return lastSlot;
+    }
+
+    /**
+     * @brief appendFreeSlot appends a new slot to the free list.
+     */
+    void appendFreeSlot();
+
+    /**
+     * @brief unlink removes a slot from the activity list.
+     * @param slot is the slot.
+     */
+    void unlink(int slot);
+
+    /**
+     * @brief linkLast appends a slot to the activity list as the most recently fed one.
+     * @param slot is the slot.
+     */
+    void linkLast(int slot);
+
+    /**
+     * @brief The Session class is the state of one stream. Open sessions form a doubly linked activity list ordered by
+     * the time they were last fed; free slots are chained through next.
+     */
+    class Session {
+    public:
+        DotsCore simplifier;
+        qint64 id;
+        double lastTime;
+        int prev, next;
+    };
+
+    // DOTS settings of new sessions.
+    double lssdTh;
+    double k;
+    int maxVkSize;
+    int maxDelayPoints;
+    double maxDelaySeconds;
+
+    // Session slots, the stream id index and the free list.
+    std::vector<Session> sessions;
+    QHash<qint64, int> sessionIndex;
+    int freeHead;
+
+    // Activity list, least recently fed first.
+    int activeHead;
+    int activeTail;
+
+    // The most recently looked up session.
+    qint64 lastId;
+    int lastSlot;
+
+signals:
+
+public slots:
+};
+
+#endif // DOTSSESSIONMANAGER_H
@@ -10,117 +10,139 @@
 #include<QVector>
 #include<QtMath>
 #include<QDebug>
+#include<QElapsedTimer>
+#include<atomic>
+#include<memory>
+#include<thread>
+#include"SpscQueue.h"
 
-DotsSimplifier::DotsSimplifier(QObject *parent, DotsSimplifier *cascadeRoot) : QObject(parent)
+DotsSimplifier::DotsSimplifier(QObject *parent, DotsSimplifier *cascadeRoot) :
+    QObject(parent), core(cascadeRoot == NULL ? NULL : &(cascadeRoot->core))
 {
-    lssdTh = 10000.0;
-    lssdUpperBound = lssdTh*2.0;
-    maxVkSize = 1e6;
-    resetInternalData();
-
-    // Assign reference to the root DOTS simplifier.
-    isCascadeRoot = (cascadeRoot == NULL);
-    if (isCascadeRoot)
-        cascadeRoot = this;
-    pX = &(cascadeRoot->ptx);
-    pY = &(cascadeRoot->pty);
-    pT = &(cascadeRoot->ptt);
-    pXSum = &(cascadeRoot->xSum);
-    pYSum = &(cascadeRoot->ySum);
-    pTSum = &(cascadeRoot->tSum);
-    pX2Sum = &(cascadeRoot->x2Sum);
-    pY2Sum = &(cascadeRoot->y2Sum);
-    pT2Sum = &(cascadeRoot->t2Sum);
-    pXTSum = &(cascadeRoot->xtSum);
-    pYTSum = &(cascadeRoot->ytSum);
 }
 
 void DotsSimplifier::setParameters(double lssdTh, double k, int maxVkSize)
 {
-    this->lssdTh = lssdTh;
-    lssdUpperBound = lssdTh*k;
-    this->maxVkSize = maxVkSize;
+    core.setParameters(lssdTh, k, maxVkSize);
 }
 
-void DotsSimplifier::resetInternalData()
+void DotsSimplifier::setStreamingMode(bool enabled)
 {
-    // Clear data points and internal statistics.
-    ptx.clear();
-    pty.clear();
-    ptt.clear();
-    ptIndex.clear();
-    xSum.clear();
-    ySum.clear();
-    tSum.clear();
-    x2Sum.clear();
-    y2Sum.clear();
-    t2Sum.clear();
-    xtSum.clear();
-    ytSum.clear();
-
-    // Clear structures for DAG construction and optimization.
-    vK.clear();
-    vL.clear();
-    terminated.clear();
-    numTerminated = 0;
-    pathK.clear();
-    issed.clear();
-    parents.clear();
-
-    // Input/output queue position.
-    simplifiedIndex.clear();
-    inputCount = 0;
-    outputCount = 0;
+    core.setStreamingMode(enabled);
+}
 
-    // Finish flag.
-    finished = false;
+void DotsSimplifier::setOutputBudget(double ratio)
+{
+    try
+    {
+        core.setOutputBudget(ratio);
+    }
+    catch (const std::exception &e)
+    {
+        DotsException(QString::fromLocal8Bit(e.what())).raise();
+    }
 }
 
-void DotsSimplifier::finish()
+void DotsSimplifier::setMaxDelay(int maxPoints, double maxSeconds)
 {
-    if (!finished)
+    try
     {
-        finished = true;
-        // Run DAG search once again to finish the simplification work.
-        directedAcyclicGraphSearch();
+        core.setMaxDelay(maxPoints, maxSeconds);
+    }
+    catch (const std::exception &e)
+    {
+        DotsException(QString::fromLocal8Bit(e.what())).raise();
     }
 }
 
+int DotsSimplifier::getForcedCommitCount()
+{
+    return core.getForcedCommitCount();
+}
+
+DotsStats DotsSimplifier::getStats()
+{
+    return core.getStats();
+}
+
+void DotsSimplifier::resetInternalData()
+{
+    core.resetInternalData();
+}
+
+int DotsSimplifier::getSimplifiedIndex(int i)
+{
+    try
+    {
+        return core.getSimplifiedIndex(i);
+    }
+    catch (const std::exception &e)
+    {
+        DotsException(QString::fromLocal8Bit(e.what())).raise();
+    }
+    return -1;
+}
+
+void DotsSimplifier::finish()
+{
+    core.finish();
+}
+
 double DotsSimplifier::getLssdThreshold()
 {
-    return this->lssdTh;
+    return core.getLssdThreshold();
 }
 
 double DotsSimplifier::getAverageSED()
 {
-    if (!finished)
-        DotsException("Calling getAverageSSED() is not allowed before finished feeding data.").raise();
-    if (inputCount<1)
-        DotsException("No data points in the containers.").raise();
-
-    return qSqrt(issed.at(inputCount-1)/inputCount);
+    try
+    {
+        return core.getAverageSED();
+    }
+    catch (const std::exception &e)
+    {
+        DotsException(QString::fromLocal8Bit(e.what())).raise();
+    }
+    return 0;
 }
 
 double DotsSimplifier::getMaxLSSD()
 {
-    if (!finished)
-        DotsException("Calling getMaxLSSD() is not allowed before finished feeding data.").raise();
-    if (inputCount<1)
-        DotsException("No data points in the containers.").raise();
-
-    // LSSD
-    double ret = 0;
-    int node = inputCount-1;
-    do
+    try
+    {
+        return core.getMaxLSSD();
+    }
+    catch (const std::exception &e)
+    {
+        DotsException(QString::fromLocal8Bit(e.what())).raise();
+    }
+    return 0;
+}
+
+QByteArray DotsSimplifier::saveState()
+{
+    std::string state;
+    try
+    {
+        core.saveState(state);
+    }
+    catch (const std::exception &e)
+    {
+        DotsException(QString::fromLocal8Bit(e.what())).raise();
+    }
+    return QByteArray(state.data(), static_cast<int>(state.size()));
+}
+
+void DotsSimplifier::restoreState(const QByteArray &state)
+{
+    try
     {
-        int parentNode = parents.at(node);
-        double lssd = issed.at(node)-issed.at(parentNode);
-        if (ret < lssd)
-            ret = lssd;
-        node = parentNode;
-    } while (node>0);
-
-    return ret;
+        core.restoreState(state.constData(), state.size());
+    }
+    catch (const std::exception &e)
+    {
+        DotsException(QString::fromLocal8Bit(e.what())).raise();
+    }
 }
 
 void DotsSimplifier::batchDots(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
@@ -140,19 +162,20 @@ void DotsSimplifier::batchDots(const QVector<double> &x, const QVector<double> &
 }
 
 void DotsSimplifier::batchDotsByIndex(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
-                                      QVector<int> &simplifiedIndex, double lssdThreshold)
+                                      QVector<int> &simplifiedIndex, double lssdThreshold, DotsStats *stats)
 {
-    DotsSimplifier simplifier;
+    DotsCore simplifier;
     // Set the simplification tolerance to 3km.
     simplifier.setParameters(lssdThreshold);
     int pointCount = x.count();
     int idx;
     simplifiedIndex.clear();
 
+    // A new simplifier accepts data, so the points are fed unchecked.
     for(int i=0; i<pointCount; ++i)
     {
         // Feed one point.
-        simplifier.feedData(x.at(i), y.at(i), t.at(i));
+        simplifier.feedDataUnchecked(x.at(i), y.at(i), t.at(i));
         // Check if there's output data.
         if(simplifier.readOutputIndex(idx))
         {
@@ -172,6 +195,188 @@ void DotsSimplifier::batchDotsByIndex(const QVector<double> &x, const QVector<do
     }
 //    qDebug("Average SED of the simplified trajectory is %.3f meters.", simplifier.getAverageSED());
     //    qDebug("Maximum LSSD is %.3f", simplifier.getMaxLSSD());
+    if (stats != NULL)
+        stats->merge(simplifier.getStats());
+}
+
+void DotsSimplifier::batchDots3DByIndex(const QVector<double> &x, const QVector<double> &y, const QVector<double> &z,
+                                        const QVector<double> &t, QVector<int> &simplifiedIndex, double lssdThreshold,
+                                        DotsStats *stats)
+{
+    Helper::checkIntEqual(x.count(), y.count());
+    Helper::checkIntEqual(x.count(), z.count());
+    Helper::checkIntEqual(x.count(), t.count());
+    DotsCore3D simplifier;
+    simplifier.setParameters(lssdThreshold);
+    simplifiedIndex.clear();
+
+    // A new simplifier accepts data, so the points are fed unchecked.
+    int pointCount = x.count();
+    int idx;
+    for (int i=0; i<pointCount; ++i)
+    {
+        const double position[3] = {x.at(i), y.at(i), z.at(i)};
+        simplifier.feedPointUnchecked(position, t.at(i));
+        if (simplifier.readOutputIndex(idx))
+            simplifiedIndex.append(idx);
+    }
+    simplifier.finish();
+    while (simplifier.readOutputIndex(idx))
+        simplifiedIndex.append(idx);
+    if (stats != NULL)
+        stats->merge(simplifier.getStats());
+}
+
+void DotsSimplifier::batchDotsSegmentedByIndex(const QVector<double> &x, const QVector<double> &y,
+                                               const QVector<double> &t, QVector<int> &simplifiedIndex,
+                                               double lssdThreshold, double maxTimeGap, double maxDistanceGap,
+                                               int threadCount, DotsStats *stats)
+{
+    simplifiedIndex.clear();
+    QVector<int> segmentStarts;
+    Helper::splitByGaps(x, y, t, maxTimeGap, maxDistanceGap, segmentStarts);
+    int segmentCount = segmentStarts.count();
+    if (segmentCount == 0)
+        return;
+    segmentStarts.append(x.count());
+
+    // Simplify the segments independently.
+    std::vector<std::vector<int> > outputs(segmentCount);
+    std::vector<DotsStats> segmentStats(segmentCount);
+    runParallel(segmentCount, threadCount, [&](int k) {
+        simplifyRange(x, y, t, segmentStarts.at(k), segmentStarts.at(k+1), lssdThreshold, outputs[k],
+                      &segmentStats[k]);
+    });
+
+    // Stitch the segments in order.
+    for (int k=0; k<segmentCount; ++k)
+    {
+        for (size_t m=0; m<outputs[k].size(); ++m)
+            simplifiedIndex.append(outputs[k][m]);
+        if (stats != NULL)
+            stats->merge(segmentStats[k]);
+    }
+}
+
+void DotsSimplifier::batchDotsChunkedByIndex(const QVector<double> &x, const QVector<double> &y,
+                                             const QVector<double> &t, QVector<int> &simplifiedIndex,
+                                             double lssdThreshold, int chunkSize, int overlap, int threadCount,
+                                             DotsChunkReport *report)
+{
+    Helper::checkIntEqual(x.count(), y.count());
+    Helper::checkIntEqual(x.count(), t.count());
+    if (chunkSize <= 0 || overlap < 0 || overlap >= chunkSize)
+        DotsException(QString("The overlap %1 must be in range [0, %2).").arg(overlap).arg(chunkSize)).raise();
+
+    QElapsedTimer timer;
+    timer.start();
+    simplifiedIndex.clear();
+    int pointCount = x.count();
+    int chunkCount = qMax(1, (pointCount+chunkSize-1)/chunkSize);
+
+    // Simplify the chunks together with their overlaps.
+    std::vector<std::vector<int> > chunkOutputs(chunkCount);
+    int usedThreads = runParallel(chunkCount, threadCount, [&](int k) {
+        int begin = qMax(0, k*chunkSize-overlap);
+        int end = qMin(pointCount, (k+1)*chunkSize+overlap);
+        simplifyRange(x, y, t, begin, end, lssdThreshold, chunkOutputs[k]);
+    });
+
+    // Keep the outputs of each chunk up to overlap/2 points before the next cut. The seam window then spans from the
+    // last kept output to the first output of the next chunk at least overlap/2 points after the cut. The ends of a
+    // window depend on the chunk outputs only, so all windows could be decided before any of them is simplified.
+    int margin = overlap/2;
+    std::vector<std::vector<int> > kept(chunkCount);
+    std::vector<int> seamBegin, seamEnd;
+    int last = -1;
+    for (int k=0; k<chunkCount; ++k)
+    {
+        const std::vector<int> &output = chunkOutputs[k];
+        int limit = (k == chunkCount-1) ? pointCount : (k+1)*chunkSize-margin;
+        for (size_t m=0; m<output.size() && output[m]<limit; ++m)
+        {
+            if (output[m] > last)
+            {
+                kept[k].push_back(output[m]);
+                last = output[m];
+            }
+        }
+        // A window may already have reached the end of a short last chunk.
+        if (k == chunkCount-1 || last == pointCount-1)
+            break;
+
+        // Chunk k+1 outputs its last point, which is overlap points past the cut or the end of the trajectory, so a
+        // window end always exists.
+        const std::vector<int> &next = chunkOutputs[k+1];
+        int target = qMin((k+1)*chunkSize+margin, pointCount-1);
+        size_t m = 0;
+        while (next[m] < target || next[m] <= last)
+            ++m;
+        seamBegin.push_back(last);
+        seamEnd.push_back(next[m]);
+        last = next[m];
+        kept[k+1].push_back(last);
+    }
+
+    // Reconcile the seams by simplifying the windows again.
+    int seamCount = static_cast<int>(seamBegin.size());
+    std::vector<std::vector<int> > seamOutputs(seamCount);
+    runParallel(seamCount, threadCount, [&](int s) {
+        simplifyRange(x, y, t, seamBegin[s], seamEnd[s]+1, lssdThreshold, seamOutputs[s]);
+    });
+
+    // Stitch the kept outputs and the inner points of the windows in order.
+    for (int k=0; k<chunkCount; ++k)
+    {
+        for (size_t m=0; m<kept[k].size(); ++m)
+            simplifiedIndex.append(kept[k][m]);
+        if (k < seamCount)
+        {
+            const std::vector<int> &output = seamOutputs[k];
+            for (size_t m=1; m+1<output.size(); ++m)
+                simplifiedIndex.append(output[m]);
+        }
+    }
+    double chunkedSeconds = timer.nsecsElapsed()*1e-9;
+
+    // Compare to the sequential run.
+    if (report != NULL)
+    {
+        QVector<int> sequentialIndex;
+        timer.start();
+        batchDotsByIndex(x, y, t, sequentialIndex, lssdThreshold);
+        report->sequentialSeconds = timer.nsecsElapsed()*1e-9;
+        report->chunkedSeconds = chunkedSeconds;
+        report->chunkCount = chunkCount;
+        report->threadCount = usedThreads;
+        report->chunkedCount = simplifiedIndex.count();
+        report->sequentialCount = sequentialIndex.count();
+        report->chunkedIssed = pathIssed(x, y, t, simplifiedIndex);
+        report->sequentialIssed = pathIssed(x, y, t, sequentialIndex);
+    }
+}
+
+double DotsSimplifier::batchDotsByBudget(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                                         QVector<int> &simplifiedIndex, int targetCount, double lssdThreshold)
+{
+    int pointCount = x.count();
+    simplifiedIndex.clear();
+    if (pointCount == 0)
+        return lssdThreshold;
+    if (targetCount < 2)
+        DotsException(QString("The target point count %1 is less than 2.").arg(targetCount)).raise();
+
+    DotsCore simplifier;
+    simplifier.setParameters(lssdThreshold);
+    simplifier.setOutputBudget(qMin(1.0, (double)targetCount/pointCount));
+    simplifier.reserve(pointCount);
+    simplifier.feedBatchUnchecked(x.constData(), y.constData(), t.constData(), pointCount);
+    simplifier.finish();
+
+    int idx;
+    while (simplifier.readOutputIndex(idx))
+        simplifiedIndex.append(idx);
+    return simplifier.getLssdThreshold();
 }
 
 void DotsSimplifier::batchDotsCascade(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
@@ -201,45 +406,227 @@ void DotsSimplifier::batchDotsCascadeByIndex(const QVector<double> &x, const QVe
 void DotsSimplifier::batchDotsCascadeByIndexOptions(const QVector<double> &x, const QVector<double> &y,
                                                     const QVector<double> &t,
                                                     QVector<int> &simplifiedIndex, double lssdThreshold,
-                                                    double thStart, double thStep)
+                                                    double thStart, double thStep, DotsStats *stats)
 {
     // Clear output.
     simplifiedIndex.clear();
 
     // Construct cascade simplifier.
-    double startThreshold = thStart < lssdThreshold/8.0 ? thStart : lssdThreshold/8.0;
-    int cascadeCount = qFloor(qLn(lssdThreshold/startThreshold)/qLn(thStep))+1;
-    double k = qPow(lssdThreshold/startThreshold, 1.0/(cascadeCount-1));
-    double th = startThreshold;
-    QObject *root = new QObject();
-    QVector<DotsSimplifier *> cascade;
+    std::vector<DotsCore> cascade;
+    buildCascade(lssdThreshold, thStart, thStep, cascade);
+    int cascadeCount = static_cast<int>(cascade.size());
+
+    // Run DOTS in cascade manner.
+    runCascade(x, y, t, cascade, simplifiedIndex, NULL);
+
+    // Collect statistics of all levels.
+    for (int i=0; stats!=NULL && i<cascadeCount; ++i)
+        stats->merge(cascade[i].getStats());
+}
+
+void DotsSimplifier::batchDotsCascadeLevelsByIndex(const QVector<double> &x, const QVector<double> &y,
+                                                   const QVector<double> &t,
+                                                   QVector<QVector<int> > &levelIndex, QVector<double> &levelThresholds,
+                                                   double lssdThreshold, double thStart, double thStep,
+                                                   DotsStats *stats)
+{
+    // Construct cascade simplifier.
+    std::vector<DotsCore> cascade;
+    buildCascade(lssdThreshold, thStart, thStep, cascade);
+    int cascadeCount = static_cast<int>(cascade.size());
+
+    // Clear output.
+    levelIndex.clear();
+    levelIndex.resize(cascadeCount);
+    levelThresholds.clear();
     for (int i=0; i<cascadeCount; ++i)
+        levelThresholds.append(cascade[i].getLssdThreshold());
+
+    // Run DOTS in cascade manner, keeping the output of every level.
+    runCascade(x, y, t, cascade, levelIndex.last(), &levelIndex);
+
+    // Collect statistics of all levels.
+    for (int i=0; stats!=NULL && i<cascadeCount; ++i)
+        stats->merge(cascade[i].getStats());
+}
+
+void DotsSimplifier::batchDotsCascadeByIndexPipelined(const QVector<double> &x, const QVector<double> &y,
+                                                      const QVector<double> &t,
+                                                      QVector<int> &simplifiedIndex, double lssdThreshold,
+                                                      double thStart, double thStep, DotsStats *stats)
+{
+    // Markers passed down the pipeline. A level reads no output after the feeds that follow FINISHING, which
+    // matches the finishing order of batchDotsCascadeByIndexOptions().
+    const int FINISHING = -2;
+    const int END = -1;
+    const int QUEUE_SIZE = 4096;
+
+    // Clear output.
+    simplifiedIndex.clear();
+
+    // Construct cascade simplifier. The input data of the root must not be reallocated while it is being fed, as
+    // the other levels read it concurrently.
+    std::vector<DotsCore> cascade;
+    buildCascade(lssdThreshold, thStart, thStep, cascade);
+    int cascadeCount = static_cast<int>(cascade.size());
+    cascade[0].reserve(x.count());
+
+    // Queue j connects level j to level j+1. The last level outputs to simplifiedIndex.
+    std::vector<std::unique_ptr<SpscQueue<int> > > queues;
+    for (int j=0; j<cascadeCount-1; ++j)
+        queues.emplace_back(new SpscQueue<int>(QUEUE_SIZE));
+    std::vector<int> output;
+    auto emitIndex = [&](int level, int index) {
+        if (level < cascadeCount-1)
+            queues[level]->push(index);
+        else
+            output.push_back(index);
+    };
+
+    // Run the levels but the first on their own threads. Indices are fed unchecked, as a level is not finished before
+    // END, so no exception is raised on the worker threads.
+    std::vector<std::thread> workers;
+    for (int j=1; j<cascadeCount; ++j)
     {
-        DotsSimplifier *s = new DotsSimplifier(root, i==0 ? NULL : cascade[0]);
-        s->setParameters(th, k);
-        th*=k;
-        cascade.append(s);
+        workers.emplace_back([&, j]() {
+            DotsCore &s = cascade[j];
+            SpscQueue<int> &in = *queues[j-1];
+            bool upstreamFinishing = false;
+            int index = -1;
+            while (true)
+            {
+                int received = in.pop();
+                if (received == END)
+                    break;
+                if (received == FINISHING)
+                {
+                    upstreamFinishing = true;
+                    continue;
+                }
+                s.feedIndexUnchecked(received);
+                if (!upstreamFinishing && s.readOutputIndex(index))
+                    emitIndex(j, index);
+            }
+
+            // Finish this level and flush it downstream.
+            s.finish();
+            if (j < cascadeCount-1)
+                queues[j]->push(FINISHING);
+            while (s.readOutputIndex(index))
+                emitIndex(j, index);
+            if (j < cascadeCount-1)
+                queues[j]->push(END);
+        });
     }
 
-    // Run DOTS in cascade manner.
+    // Run the first level on this thread.
+    DotsCore &first = cascade[0];
+    int pointCount = x.count();
+    int index = -1;
+    for (int i=0; i<pointCount; ++i)
+    {
+        first.feedDataUnchecked(x.at(i), y.at(i), t.at(i));
+        if (first.readOutputIndex(index))
+            emitIndex(0, index);
+    }
+    first.finish();
+    if (cascadeCount > 1)
+        queues[0]->push(FINISHING);
+    while (first.readOutputIndex(index))
+        emitIndex(0, index);
+    if (cascadeCount > 1)
+        queues[0]->push(END);
+
+    for (size_t j=0; j<workers.size(); ++j)
+        workers[j].join();
+
+    // Store output.
+    simplifiedIndex.reserve(static_cast<int>(output.size()));
+    for (size_t k=0; k<output.size(); ++k)
+        simplifiedIndex.append(output[k]);
+
+    // Collect statistics of all levels.
+    for (int i=0; stats!=NULL && i<cascadeCount; ++i)
+        stats->merge(cascade[i].getStats());
+}
+
+int DotsSimplifier::runParallel(int taskCount, int threadCount, const std::function<void(int)> &task)
+{
+    if (threadCount <= 0)
+        threadCount = qMax(1, static_cast<int>(std::thread::hardware_concurrency()));
+    threadCount = qMax(1, qMin(threadCount, taskCount));
+
+    std::atomic<int> nextTask(0);
+    auto work = [&]() {
+        int k;
+        while ((k = nextTask.fetch_add(1)) < taskCount)
+            task(k);
+    };
+    std::vector<std::thread> workers;
+    for (int i=1; i<threadCount; ++i)
+        workers.emplace_back(work);
+    work();
+    for (size_t i=0; i<workers.size(); ++i)
+        workers[i].join();
+    return threadCount;
+}
+
+void DotsSimplifier::simplifyRange(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                                   int begin, int end, double lssdThreshold, std::vector<int> &output,
+                                   DotsStats *stats)
+{
+    // A new simplifier accepts data, so the range is fed unchecked and no exception leaves a worker thread.
+    DotsCore simplifier;
+    simplifier.setParameters(lssdThreshold);
+    simplifier.reserve(end-begin);
+    simplifier.feedBatchUnchecked(x.constData()+begin, y.constData()+begin, t.constData()+begin, end-begin);
+    simplifier.finish();
+    output.clear();
+    simplifier.drainOutput(output);
+    for (size_t m=0; m<output.size(); ++m)
+        output[m] += begin;
+    if (stats != NULL)
+        *stats = simplifier.getStats();
+}
+
+double DotsSimplifier::pathIssed(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                                 const QVector<int> &simplifiedIndex)
+{
+    PrefixStatistics statistics(x.constData(), y.constData(), t.constData(), x.count());
+    double issed = 0;
+    for (int k=1; k<simplifiedIndex.count(); ++k)
+        issed += statistics.lssd(simplifiedIndex.at(k-1), simplifiedIndex.at(k));
+    return issed;
+}
+
+void DotsSimplifier::runCascade(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                                std::vector<DotsCore> &cascade, QVector<int> &simplifiedIndex,
+                                QVector<QVector<int> > *levelIndex)
+{
+    int cascadeCount = static_cast<int>(cascade.size());
+
+    // Run DOTS in cascade manner. The levels are new and not finished before they are fed for the last time, so data
+    // and indices are fed unchecked.
     int pointCount = x.count();
     double px, py, pt;
-    DotsSimplifier *first = cascade[0];
+    DotsCore &first = cascade[0];
     for (int i=0; i<pointCount; ++i)
     {
         px = x.at(i);
         py = y.at(i);
         pt = t.at(i);
-        first->feedData(px, py, pt);
+        first.feedDataUnchecked(px, py, pt);
         int index = -1;
-        if (first->readOutputIndex(index))
+        if (first.readOutputIndex(index))
         {
             bool gotOutput = true;
             for (int j=1; j<cascadeCount; ++j)
             {
-                DotsSimplifier *s = cascade[j];
-                s->feedIndex(index);
-                if (!(s->readOutputIndex(index)))
+                if (levelIndex != NULL)
+                    (*levelIndex)[j-1].append(index);
+                DotsCore &s = cascade[j];
+                s.feedIndexUnchecked(index);
+                if (!(s.readOutputIndex(index)))
                 {
                     gotOutput = false;
                     break;
@@ -258,23 +645,40 @@ void DotsSimplifier::batchDotsCascadeByIndexOptions(const QVector<double> &x, co
     // Finish simplifiers from front to end.
     for (int i=0; i<cascadeCount-1; ++i)
     {
-        DotsSimplifier *s = cascade[i];
-        DotsSimplifier *n = cascade[i+1];
-        s->finish();
+        DotsCore &s = cascade[i];
+        DotsCore &n = cascade[i+1];
+        s.finish();
         int index = -1;
-        while (s->readOutputIndex(index))
-            n->feedIndex(index);
+        while (s.readOutputIndex(index))
+        {
+            if (levelIndex != NULL)
+                (*levelIndex)[i].append(index);
+            n.feedIndexUnchecked(index);
+        }
     }
     // Read output from the last simplifier.
-    DotsSimplifier *last = cascade.last();
-    last->finish();
+    DotsCore &last = cascade.back();
+    last.finish();
     int index = -1;
-    while (last->readOutputIndex(index))
+    while (last.readOutputIndex(index))
     {
         simplifiedIndex.append(index);
         //qDebug()<<(pointCount-1)<<","<<simplifiedIndex.last();
     }
+}
 
-    // Destroy the total cascade.
-    delete root;
+void DotsSimplifier::buildCascade(double lssdThreshold, double thStart, double thStep, std::vector<DotsCore> &cascade)
+{
+    double startThreshold = thStart < lssdThreshold/8.0 ? thStart : lssdThreshold/8.0;
+    int cascadeCount = qFloor(qLn(lssdThreshold/startThreshold)/qLn(thStep))+1;
+    double k = qPow(lssdThreshold/startThreshold, 1.0/(cascadeCount-1));
+    double th = startThreshold;
+    cascade.clear();
+    cascade.reserve(cascadeCount);
+    for (int i=0; i<cascadeCount; ++i)
+    {
+        cascade.emplace_back(i==0 ? NULL : &cascade[0]);
+        cascade.back().setParameters(th, k);
+        th*=k;
+    }
 }
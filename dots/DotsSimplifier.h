@@ -15,9 +15,52 @@
 #define DOTSSIMPLIFIER_H
 
 #include <QObject>
+#include<QByteArray>
 #include<QString>
 #include<QVector>
+#include<exception>
+#include<functional>
 #include"DotsException.h"
+#include"DotsCore.h"
+
+/**
+ * @brief The DotsChunkReport class describes a run of DotsSimplifier::batchDotsChunkedByIndex() against the sequential
+ * DotsSimplifier::batchDotsByIndex() on the same trajectory.
+ */
+class DotsChunkReport
+{
+public:
+    /**
+     * @brief speedup retrieves how many times faster the chunked run was.
+     * @return the ratio of the sequential time to the chunked time.
+     */
+    double speedup() const
+    {
+        return chunkedSeconds > 0 ? sequentialSeconds/chunkedSeconds : 0;
+    }
+
+    /**
+     * @brief issedDelta retrieves the relative ISSED difference of the chunked result to the sequential one.
+     * @return the relative difference, positive if the chunked result has the larger error.
+     */
+    double issedDelta() const
+    {
+        return sequentialIssed > 0 ? (chunkedIssed-sequentialIssed)/sequentialIssed : 0;
+    }
+
+    // Number of chunks and threads used.
+    int chunkCount;
+    int threadCount;
+    // Wall clock time of both runs in seconds.
+    double chunkedSeconds;
+    double sequentialSeconds;
+    // Number of output points of both runs.
+    int chunkedCount;
+    int sequentialCount;
+    // ISSED, i.e. the total LSSD of the simplified trajectory, of both runs.
+    double chunkedIssed;
+    double sequentialIssed;
+};
 
 /**
  * @brief The DotsSimplifier class implements the trajectory simplification algorithm DOTS.
@@ -31,6 +74,10 @@
  * Third, it solves not only the min-# problem but also (partially) the min-e problem.
  * Forth, the time cost is relatively low. The time complexity is O(N/M) for each input point. Note that N/M
  * represents the simplification or compression rate.
+ *
+ * This class is the Qt adapter of DotsCore, which holds the algorithm itself: it takes a QObject parent, raises
+ * DotsException on misuse and provides batched utilities on QVector. Code that does not need Qt may use DotsCore
+ * directly.
  */
 class DotsSimplifier : public QObject
 {
@@ -51,118 +98,114 @@ public:
      */
     void setParameters(double lssdTh, double k = 2.0, int maxVkSize = 1e6);
 
+    /**
+     * @brief setStreamingMode enables or disables the bounded-memory streaming mode. See DotsCore::setStreamingMode().
+     * @param enabled is true to enable streaming mode, false otherwise.
+     */
+    void setStreamingMode(bool enabled);
+
+    /**
+     * @brief setOutputBudget enables or disables the output budget (min-#) mode. See DotsCore::setOutputBudget().
+     * @param ratio is the target ratio of output points to input points in (0, 1], or 0 to disable the mode.
+     */
+    void setOutputBudget(double ratio);
+
+    /**
+     * @brief setMaxDelay bounds the output latency. See DotsCore::setMaxDelay().
+     * @param maxPoints is the maximum number of input points between the last decided point and the newest one, or 0
+     * for no bound.
+     * @param maxSeconds is the maximum time between the last decided point and the newest one, or 0 for no bound.
+     */
+    void setMaxDelay(int maxPoints, double maxSeconds = 0);
+
+    /**
+     * @brief getForcedCommitCount retrieves the number of commits forced by the maximum delay since the last reset.
+     * @return the number of forced commits.
+     */
+    int getForcedCommitCount();
+
+    /**
+     * @brief getStats retrieves the hot-path statistics since the last reset. See DotsCore::getStats().
+     * @return the statistics.
+     */
+    DotsStats getStats();
+
     /**
      * @brief resetInternalData resets all internal data structures for DOTS algorithm.
      */
     void resetInternalData();
 
     /**
-     * @brief feedData feeds a 2D spatio temporary point to DOTS.
+     * @brief feedData feeds a 2D spatio temporary point to DOTS. Positions and timestamps may be absolute values such
+     * as projected meters and Unix epoch seconds, as LSSD is evaluated relative to a local origin from compensated
+     * prefix sums (see PrefixStatisticsT).
      * @param x is the x position.
      * @param y is the y position.
      * @param t is the timestamp.
      */
     inline void feedData(double x, double y, double t)
     {
-        if (finished)
-            DotsException("Feeding data is NOT allowed after the simplifier finished. "\
-                          "Suggest calling resetInternalData() first.").raise();
-        if (!isCascadeRoot)
-            DotsException("We can only feed index to non-root simplifier. "\
-                          "Try feedIndex() instead.").raise();
-
-        // Store data.
-        ptx.append(x);
-        pty.append(y);
-        ptt.append(t);
-        ptIndex.append(ptIndex.count());
-        // Update internal data.
-        if (ptIndex.count() == 1)
+        try
+        {
+            core.feedData(x, y, t);
+        }
+        catch (const std::exception &e)
+        {
+            DotsException(QString::fromLocal8Bit(e.what())).raise();
+        }
+    }
+
+    /**
+     * @brief feedBatch feeds n 2D spatio temporary points to DOTS at once. See DotsCore::feedBatch().
+     * @param x is the x positions.
+     * @param y is the y positions.
+     * @param t is the timestamps.
+     * @param n is the number of points.
+     */
+    inline void feedBatch(const double *x, const double *y, const double *t, size_t n)
+    {
+        try
         {
-            if (qAbs(t) > 3600*24*365)
-            {
-                DotsException("The first timestamp seems so big that DOTS would potentially fail "\
-                              "due to numerical errors. Would you please consider normalizing the "\
-                              "input data properly first?").raise();
-            }
-            if (qAbs(x) > 2000*1000 || qAbs(y) > 2000*1000)
-            {
-                DotsException("The first position seems so big that DOTS would potentially fail "\
-                              "due to numerical errors. Would you please consider normalizing the "\
-                              "input data properly first?").raise();
-            }
-            xSum.append(x);
-            ySum.append(y);
-            tSum.append(t);
-            x2Sum.append(x*x);
-            y2Sum.append(y*y);
-            t2Sum.append(t*t);
-            xtSum.append(x*t);
-            ytSum.append(y*t);
-
-            // Setup the initial vK set {0}.
-            vK.append(0);
-            terminated.append(false);
-            numTerminated = 0;
-
-            // Setup the following-path for viterbi decoding.
-            QVector<int> path;
-            path.append(0);
-            pathK.append(path);
-
-            // Set input/output queue.
-            inputCount = 1;
-            outputCount = 0;
-            simplifiedIndex.append(0);
+            core.feedBatch(x, y, t, n);
         }
-        else
+        catch (const std::exception &e)
         {
-            int count = xSum.count()-1;
-            xSum.append(xSum[count]+x);
-            ySum.append(ySum[count]+y);
-            tSum.append(tSum[count]+t);
-            x2Sum.append(x2Sum[count]+x*x);
-            y2Sum.append(y2Sum[count]+y*y);
-            t2Sum.append(t2Sum[count]+t*t);
-            xtSum.append(xtSum[count]+x*t);
-            ytSum.append(ytSum[count]+y*t);
+            DotsException(QString::fromLocal8Bit(e.what())).raise();
         }
-        // Initialize issed&parents.
-        issed.append(0);
-        parents.append(-1);
     }
 
     inline void feedIndex(int index)
     {
-        if (finished)
-            DotsException("Feeding data is NOT allowed after the simplifier finished. "\
-                          "Suggest calling resetInternalData() first.").raise();
-        if (isCascadeRoot)
-            DotsException("We can only feed data to the cascade root simplifier. "\
-                          "Try feedData() instead.").raise();
-
-        ptIndex.append(index);
-        // Update internal data.
-        if (ptIndex.count() == 1)
+        try
         {
-            // Setup the initial vK set {0}.
-            vK.append(0);
-            terminated.append(false);
-            numTerminated = 0;
-
-            // Setup the following-path for viterbi decoding.
-            QVector<int> path;
-            path.append(0);
-            pathK.append(path);
-
-            // Set input/output queue.
-            inputCount = 1;
-            outputCount = 0;
-            simplifiedIndex.append(ptIndex.at(0));
+            core.feedIndex(index);
         }
-        // Initialize issed&parents.
-        issed.append(0);
-        parents.append(-1);
+        catch (const std::exception &e)
+        {
+            DotsException(QString::fromLocal8Bit(e.what())).raise();
+        }
+    }
+
+    /**
+     * @brief tryFeedData is the exception-free version of feedData(). See DotsCore::tryFeedData().
+     * @param x is the x position.
+     * @param y is the y position.
+     * @param t is the timestamp.
+     * @return DOTS_OK if the point was fed, the reason otherwise.
+     */
+    inline DotsStatus tryFeedData(double x, double y, double t) noexcept
+    {
+        return core.tryFeedData(x, y, t);
+    }
+
+    /**
+     * @brief tryFeedIndex is the exception-free version of feedIndex(). See DotsCore::tryFeedIndex().
+     * @param index is index of the point in the input data of the cascade root.
+     * @return DOTS_OK if the index was fed, the reason otherwise.
+     */
+    inline DotsStatus tryFeedIndex(int index) noexcept
+    {
+        return core.tryFeedIndex(index);
     }
 
     /**
@@ -175,14 +218,7 @@ public:
      */
     inline bool readOutputData(double &x, double &y, double &t)
     {
-        int index = -1;
-        if (!readOutputIndex(index))
-            return false;
-
-        x = pX->at(index);
-        y = pY->at(index);
-        t = pT->at(index);
-        return true;
+        return core.readOutputData(x, y, t);
     }
 
     /**
@@ -193,19 +229,17 @@ public:
      */
     inline bool readOutputIndex(int &index)
     {
-        // Run DAG search to produce potentially more output data.
-        if (!finished && outputCount >= simplifiedIndex.count())
-            directedAcyclicGraphSearch();
+        return core.readOutputIndex(index);
+    }
 
-        // Retrieve one data.
-        if (outputCount < simplifiedIndex.count())
-        {
-            index = ptIndex.at(simplifiedIndex.at(outputCount));
-            ++outputCount;
-            return true;
-        }
-        // No output yet.
-        return false;
+    /**
+     * @brief drainOutput runs the DAG search once and appends the indices of all points decided since the last read
+     * to output. See DotsCore::drainOutput().
+     * @param output receives the selected indices.
+     */
+    inline void drainOutput(std::vector<int> &output)
+    {
+        core.drainOutput(output);
     }
 
     /**
@@ -213,12 +247,17 @@ public:
      * @param i the point number of simplified trajectory to retrieve.
      * @return index of the i-th point.
      */
-    inline int getSimplifiedIndex(int i)
-    {
-        if (i<0 || i>=simplifiedIndex.count())
-            DotsException(QString("Index %1 is out of range [0, %2)").arg(i).arg(simplifiedIndex.count())).raise();
+    int getSimplifiedIndex(int i);
 
-        return ptIndex.at(simplifiedIndex.at(i));
+    /**
+     * @brief tryGetSimplifiedIndex is the exception-free version of getSimplifiedIndex().
+     * @param i the point number of simplified trajectory to retrieve.
+     * @param index receives index of the i-th point.
+     * @return DOTS_OK if the index was retrieved, DOTS_ERROR_OUT_OF_RANGE otherwise.
+     */
+    inline DotsStatus tryGetSimplifiedIndex(int i, int &index) const noexcept
+    {
+        return core.tryGetSimplifiedIndex(i, index);
     }
 
     /**
@@ -245,6 +284,19 @@ public:
      */
     double getMaxLSSD();
 
+    /**
+     * @brief saveState takes a snapshot of this simplifier and all its cascade levels. See DotsCore::saveState().
+     * @return the snapshot.
+     */
+    QByteArray saveState();
+
+    /**
+     * @brief restoreState replaces the state of this simplifier and all its cascade levels by a snapshot taken by
+     * saveState(). See DotsCore::restoreState().
+     * @param state is the snapshot.
+     */
+    void restoreState(const QByteArray &state);
+
     /**
      * @brief batchDots provides a batched simplification utility by invoking the online DOTS simplifier.
      * @param x
@@ -259,8 +311,89 @@ public:
                           QVector<double> &ox, QVector<double> &oy, QVector<double> &ot,
                           double lssdThreshold);
 
+    /**
+     * @brief batchDotsByIndex simplifies a trajectory by DOTS and retrieves indices of the simplified points.
+     * @param x
+     * @param y
+     * @param t
+     * @param simplifiedIndex
+     * @param lssdThreshold
+     * @param stats receives the hot-path statistics if not NULL. They are merged into it, so that statistics of
+     * several trajectories could be accumulated. See DotsCore::getStats().
+     */
     static void batchDotsByIndex(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
-                                 QVector<int> &simplifiedIndex, double lssdThreshold);
+                                 QVector<int> &simplifiedIndex, double lssdThreshold, DotsStats *stats = NULL);
+
+    /**
+     * @brief batchDots3DByIndex simplifies a 3D trajectory, e.g. projected positions with altitude, by DOTS and
+     * retrieves indices of the simplified points. LSSD then integrates the 3D SED. See DotsCore3D.
+     * @param x
+     * @param y
+     * @param z
+     * @param t
+     * @param simplifiedIndex
+     * @param lssdThreshold
+     * @param stats receives the hot-path statistics if not NULL. They are merged into it.
+     */
+    static void batchDots3DByIndex(const QVector<double> &x, const QVector<double> &y, const QVector<double> &z,
+                                   const QVector<double> &t, QVector<int> &simplifiedIndex, double lssdThreshold,
+                                   DotsStats *stats = NULL);
+
+    /**
+     * @brief batchDotsSegmentedByIndex splits a trajectory at recording gaps (see Helper::splitByGaps()), simplifies
+     * the segments independently by DOTS on a pool of threads and stitches their outputs back together. DOTS does
+     * not have to bridge the gaps by segments of huge LSSD this way, and long trajectories with gaps are simplified
+     * on several cores. Both ends of every segment are kept.
+     * @param x
+     * @param y
+     * @param t
+     * @param simplifiedIndex
+     * @param lssdThreshold
+     * @param maxTimeGap is the maximum time between consecutive points of a segment, or 0 for no bound.
+     * @param maxDistanceGap is the maximum distance between consecutive points of a segment, or 0 for no bound.
+     * @param threadCount is the number of threads, or 0 for the number of cores.
+     * @param stats receives the hot-path statistics of all segments if not NULL. They are merged into it.
+     */
+    static void batchDotsSegmentedByIndex(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                                          QVector<int> &simplifiedIndex, double lssdThreshold, double maxTimeGap,
+                                          double maxDistanceGap, int threadCount = 0, DotsStats *stats = NULL);
+
+    /**
+     * @brief batchDotsChunkedByIndex simplifies a huge trajectory by DOTS on several cores. The trajectory is cut into
+     * chunks of chunkSize points, and each chunk is simplified concurrently together with overlap points on both
+     * sides, so that its output near the cuts is not biased by the artificial ends. At each cut the seam is
+     * reconciled: the outputs of both chunks within overlap/2 points of the cut are dropped, and DOTS runs again on
+     * the window between the last kept output before the cut and the first kept output after it. The result is
+     * a valid DOTS path whose ISSED stays close to that of batchDotsByIndex(), as the windows are decided with the
+     * same threshold and only the choice of the window ends is not optimized across the cut.
+     * @param x
+     * @param y
+     * @param t
+     * @param simplifiedIndex
+     * @param lssdThreshold
+     * @param chunkSize is the number of points per chunk.
+     * @param overlap is the number of points each chunk extends into its neighbors. It must be less than chunkSize.
+     * @param threadCount is the number of threads, or 0 for the number of cores.
+     * @param report receives the comparison to batchDotsByIndex() if not NULL. It takes a sequential run as well.
+     */
+    static void batchDotsChunkedByIndex(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                                        QVector<int> &simplifiedIndex, double lssdThreshold, int chunkSize = 262144,
+                                        int overlap = 4096, int threadCount = 0, DotsChunkReport *report = NULL);
+
+    /**
+     * @brief batchDotsByBudget simplifies a trajectory to about targetCount points in a single pass, by running DOTS in
+     * output budget mode. Short trajectories converge better if lssdThreshold is in the right order of magnitude, e.g.
+     * the threshold returned for a previous trajectory of the same source.
+     * @param x
+     * @param y
+     * @param t
+     * @param simplifiedIndex
+     * @param targetCount is the desired number of output points.
+     * @param lssdThreshold is the initial LSSD threshold.
+     * @return the LSSD threshold DOTS ended up with.
+     */
+    static double batchDotsByBudget(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                                    QVector<int> &simplifiedIndex, int targetCount, double lssdThreshold = 1000.0);
 
     /**
      * @brief batchDotsCascade provides a batched simplification utility by invoking the online DOTS simplifier in
@@ -281,354 +414,126 @@ public:
     static void batchDotsCascadeByIndex(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
                                         QVector<int> &simplifiedIndex, double lssdThreshold);
 
+    /**
+     * @brief batchDotsCascadeByIndexOptions simplifies a trajectory by cascaded DOTS and retrieves indices of the
+     * simplified points.
+     * @param x
+     * @param y
+     * @param t
+     * @param simplifiedIndex
+     * @param lssdThreshold
+     * @param thStart
+     * @param thStep
+     * @param stats receives the hot-path statistics of all cascade levels if not NULL. They are merged into it.
+     */
     static void batchDotsCascadeByIndexOptions(const QVector<double> &x, const QVector<double> &y,
                                                const QVector<double> &t,
                                                QVector<int> &simplifiedIndex, double lssdThreshold,
-                                               double thStart, double thStep);
+                                               double thStart, double thStep, DotsStats *stats = NULL);
 
-protected:
     /**
-     * @brief directedAcyclicGraphSearch does a DAG search among the feeded spatio-temporal 2D data. The output queue
-     * would be updated when appropriate.
+     * @brief batchDotsCascadeLevelsByIndex simplifies a trajectory by cascaded DOTS like
+     * batchDotsCascadeByIndexOptions(), and retrieves the indices output by every cascade level instead of the last
+     * one only. As each level simplifies the output of the previous one, the results form a nested level-of-detail
+     * pyramid, e.g. for map zoom levels, at the cost of a single cascade pass. The last level equals the result of
+     * batchDotsCascadeByIndexOptions() with the same arguments.
+     * @param x
+     * @param y
+     * @param t
+     * @param levelIndex receives the indices output by each level, the finest (root) level first.
+     * @param levelThresholds receives the LSSD threshold of each level.
+     * @param lssdThreshold
+     * @param thStart
+     * @param thStep
+     * @param stats receives the hot-path statistics of all cascade levels if not NULL. They are merged into it.
      */
-    inline void directedAcyclicGraphSearch()
-    {
-        int numPoints = ptIndex.count();
-        if (finished)
-        {
-            // Construct the DAG completely.
-            while (true)
-            {
-                if (inputCount>=numPoints)
-                    break;
-
-                // Move v* points to vL.
-                for (int i=inputCount; i<numPoints; ++i)
-                {
-                    // Update vK if parent was not assigned yet.
-                    if (parents.at(i) < 0)
-                    {
-                        for (int j=0;j<vK.count(); ++j)
-                        {
-                            int jIndex = vK.at(j);
-                            if (!terminated.at(j))
-                            {
-                                double distance = getLSSD(jIndex,i);
-                                if (distance < lssdTh)
-                                {
-                                    vL.append(i);
-                                    issed[i] = issed[jIndex]+distance;
-                                    parents[i] = jIndex;
-                                    break;
-                                }
-                                else if (distance > lssdUpperBound)
-                                {
-                                    terminated[j] = true;
-                                    ++numTerminated;
-
-                                    // Check if all vK terminated.
-                                    if (needUpdateVK())
-                                    {
-                                        break;
-                                    }
-                                }
-                            } // if (!terminated.at(j))
-                        } // for (int j=0;j<vK.count(); ++j)
-                    } // if (parents.at(i) < 0)
-
-                    // Update inputCount for consequent none v* points.
-                    if(parents.at(i)>=0 && inputCount == i)
-                    {
-                        // Update start point of DAG search.
-                        ++inputCount;
-                    }
-
-                    // Terminate loop early if we need to update vK.
-                    if (needUpdateVK())
-                        break;
-                } // for (int i=inputCount; i<numPoints; ++i)
-
-                // Minimize ISSED.
-                minimizeISSED();
-
-                // Force swap vK/vL no matter we need update vK.
-                updateVK();
-
-                // Omit viterbi decoding!!
-            }
-
-            // Decode the simplified data from back to front.
-            QVector<int> temp;
-            int idx = numPoints-1;
-            int currentIndex = -1;
-            if (!simplifiedIndex.empty())
-                currentIndex = simplifiedIndex[simplifiedIndex.count()-1];
-            while(idx>currentIndex)
-            {
-                temp.append(idx);
-                idx = parents.at(idx);
-            }
-            for (int k=temp.count()-1; k>=0; --k)
-                simplifiedIndex.append(temp.at(k));
-        } // if (finished)
-        else
-        {
-            while (true)
-            {
-                bool vKUpdated = false;
-                if (inputCount>=numPoints)
-                    break;
-
-                // Move v* points to vL.
-                for (int i=inputCount; i<numPoints; ++i)
-                {
-                    // Update vK if parent was not assigned yet.
-                    if (parents.at(i) < 0)
-                    {
-                        for (int j=0;j<vK.count(); ++j)
-                        {
-                            int jIndex = vK.at(j);
-                            if (!terminated.at(j))
-                            {
-                                double distance = getLSSD(jIndex,i);
-                                if (distance < lssdTh)
-                                {
-                                    vL.append(i);
-                                    issed[i] = issed[jIndex]+distance;
-                                    parents[i] = jIndex;
-
-                                    // Check if vL exceeds max size.
-                                    if (needUpdateVK())
-                                    {
-                                        // Minimize ISSED.
-                                        minimizeISSED();
-
-                                        // Swap vK/vL
-                                        updateVK();
-
-                                        // Viterbi decoding.
-                                        viterbiDecode();
-
-                                        // Break search loop.
-                                        vKUpdated = true;
-                                    }
-                                    break;
-                                }
-                                else if (distance > lssdUpperBound)
-                                {
-                                    terminated[j] = true;
-                                    ++numTerminated;
-
-                                    // Check if all vK terminated.
-                                    if (needUpdateVK())
-                                    {
-                                        // Minimize ISSED.
-                                        minimizeISSED();
-
-                                        // Swap vK/vL
-                                        updateVK();
-
-                                        // Viterbi decoding.
-                                        viterbiDecode();
-
-                                        // Break search loop.
-                                        vKUpdated = true;
-                                        break;
-                                    }
-                                }
-                            } // if (!terminated.at(j))
-                        } // for (int j=0;j<vK.count(); ++j)
-                    } // if (parents.at(i) < 0)
-
-                    // Update inputCount for consequent none v* points.
-                    if(parents.at(i)>=0 && inputCount == i)
-                    {
-                        // Update start point of DAG search.
-                        ++inputCount;
-                    }
-
-                    if (vKUpdated)
-                        break;
-                } // for (int i=inputCount; i<numPoints; ++i)
-
-                // Stop DAG search if no new vK generated.
-                if (!vKUpdated)
-                    break;
-            }
-        }
-    }
+    static void batchDotsCascadeLevelsByIndex(const QVector<double> &x, const QVector<double> &y,
+                                              const QVector<double> &t,
+                                              QVector<QVector<int> > &levelIndex, QVector<double> &levelThresholds,
+                                              double lssdThreshold, double thStart, double thStep,
+                                              DotsStats *stats = NULL);
 
     /**
-     * @brief getLSSD calculates the LSSD (logogram of Local integral Square Synchronous Euclidean Distance ) between
-     * two points indexed by fst and lst.
-     * @param fst is index of the first point.
-     * @param lst is index of the second point.
-     * @return the LSSD distance.
+     * @brief batchDotsCascadeByIndexPipelined is the pipelined version of batchDotsCascadeByIndexOptions(). Every
+     * cascade level but the first runs on its own thread, and the levels pass indices through lock-free
+     * single-producer/single-consumer queues, so the throughput approaches that of the slowest level. Each level sees
+     * the same feeds and reads as in batchDotsCascadeByIndexOptions(), so the output is identical.
+     * @param x
+     * @param y
+     * @param t
+     * @param simplifiedIndex
+     * @param lssdThreshold
+     * @param thStart
+     * @param thStep
+     * @param stats receives the hot-path statistics of all cascade levels if not NULL. They are merged into it.
      */
-    inline double getLSSD(int fst, int lst)
-    {
-        fst = ptIndex.at(fst);
-        lst = ptIndex.at(lst);
-        if (fst+1>=lst)
-            return 0;
-        if (fst<0 || lst>=pXSum->count())
-            DotsException(QString("Index out of bound error.")).raise();
-
-        int plst = lst-1;
-        double c1x = pX->at(fst)*pT->at(lst)-pX->at(lst)*pT->at(fst);
-        double c2x = c1x*c1x;
-        double c3x = pT->at(lst)-pT->at(fst);
-        double c4x = c3x*c3x;
-        double c5x = pX->at(lst)-pX->at(fst);
-        double c6x = c5x*c5x;
-
-        double c1y = pY->at(fst)*pT->at(lst)-pY->at(lst)*pT->at(fst);
-        double c2y = c1y*c1y;
-        double c3y = c3x;
-        double c4y = c3y*c3y;
-        double c5y = pY->at(lst)-pY->at(fst);
-        double c6y = c5y*c5y;
-
-        double distance = (plst-fst)*c2x/c4x
-                + c6x/c4x*(pT2Sum->at(plst)-pT2Sum->at(fst))
-                + (pX2Sum->at(plst)-pX2Sum->at(fst))
-                + 2*c1x*c5x/c4x*(pTSum->at(plst)-pTSum->at(fst))
-                - 2*c1x/c3x*(pXSum->at(plst)-pXSum->at(fst))
-                - 2*c5x/c3x*(pXTSum->at(plst)-pXTSum->at(fst))
-                + (plst-fst)*c2y/c4y
-                + c6y/c4y*(pT2Sum->at(plst)-pT2Sum->at(fst))
-                + (pY2Sum->at(plst)-pY2Sum->at(fst))
-                + 2*c1y*c5y/c4y*(pTSum->at(plst)-pTSum->at(fst))
-                - 2*c1y/c3y*(pYSum->at(plst)-pYSum->at(fst))
-                - 2*c5y/c3y*(pYTSum->at(plst)-pYTSum->at(fst));
-        return distance;
-    }
+    static void batchDotsCascadeByIndexPipelined(const QVector<double> &x, const QVector<double> &y,
+                                                 const QVector<double> &t,
+                                                 QVector<int> &simplifiedIndex, double lssdThreshold,
+                                                 double thStart, double thStep, DotsStats *stats = NULL);
 
+protected:
     /**
-     * @brief needUpdateVK Checks if we need to swap Vl and Vk sets.
-     * @return true if a swap operation is necessary, false otherwise.
+     * @brief runParallel runs taskCount tasks on a pool of threads. Each thread takes the next task not taken yet, so
+     * tasks of different costs balance out. The calling thread works as one of the threads.
+     * @param taskCount is the number of tasks.
+     * @param threadCount is the number of threads, or 0 for the number of cores.
+     * @param task runs the task of the given number. It must not throw.
+     * @return the number of threads used.
      */
-    inline bool needUpdateVK()
-    {
-        return (vK.count() == numTerminated || vL.count()>= maxVkSize);
-    }
+    static int runParallel(int taskCount, int threadCount, const std::function<void(int)> &task);
 
     /**
-     * @brief updateVK swaps Vl and Vk sets and updates the DAG paths from root node to each elements of current Vk set.
+     * @brief simplifyRange simplifies points [begin, end) of a trajectory by a standalone DOTS simplifier.
+     * @param x
+     * @param y
+     * @param t
+     * @param begin is index of the first point.
+     * @param end is one past index of the last point.
+     * @param lssdThreshold
+     * @param output receives the indices of the simplified points in the whole trajectory.
+     * @param stats receives the hot-path statistics if not NULL.
      */
-    inline void updateVK()
-    {
-        // Update following-path.
-        QVector< QVector<int> > newPath;
-        for (int k=0; k<vL.count(); ++k)
-        {
-            int indexK = -1;
-            int parentPos = parents.at(vL.at(k));
-            for (int m=0; m<vK.count(); ++m)
-            {
-                if (vK.at(m) == parentPos)
-                {
-                    indexK = m;
-                    break;
-                }
-            }
-
-            QVector<int> p = pathK.at(indexK);
-            p.append(vL.at(k));
-            newPath.append(p);
-        }
-        pathK = newPath;
-
-        // Update vK set.
-        vK = vL;
-        terminated.resize(vK.count());
-        for (int k=0; k<terminated.count(); ++k)
-            terminated[k] = false;
-        numTerminated = 0;
-        vL.clear();
-    }
+    static void simplifyRange(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                              int begin, int end, double lssdThreshold, std::vector<int> &output,
+                              DotsStats *stats = NULL);
 
     /**
-     * @brief minimizeISSED minimizes the total error from root node to each element of Vl set. The minimization is
-     * done by choosing the best parents of Vl elements among Vk elements.
+     * @brief pathIssed calculates the ISSED of a simplified trajectory, i.e. the total LSSD of its segments.
+     * @param x
+     * @param y
+     * @param t
+     * @param simplifiedIndex
+     * @return the ISSED.
      */
-    inline void minimizeISSED()
-    {
-        foreach (int i, vL) {
-            double minDistance = issed.at(i);
-            double minParent = parents.at(i);
-            foreach (int j, vK) {
-                double localDistance = getLSSD(j,i);
-                double distance = issed.at(j) + localDistance;
-                if (localDistance<lssdTh && distance<minDistance)
-                {
-                    minDistance = distance;
-                    minParent = j;
-                }
-            }
-            issed[i] = minDistance;
-            parents[i] = minParent;
-        }
-    }
+    static double pathIssed(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                            const QVector<int> &simplifiedIndex);
 
     /**
-     * @brief viterbiDecode decodes output indices of simplified points in a viterbi-like manner.
+     * @brief runCascade feeds a trajectory through the cascade levels and finishes them from the root to the last one.
+     * @param x
+     * @param y
+     * @param t
+     * @param cascade is the cascade levels built by buildCascade().
+     * @param simplifiedIndex receives the indices output by the last level.
+     * @param levelIndex receives the indices output by the other levels if not NULL. It must hold one vector per level.
      */
-    inline void viterbiDecode()
-    {
-        int inputLayer = pathK.at(0).count();
-        int startLayer = simplifiedIndex.count();
-        while (startLayer < inputLayer) {
-            bool equal = true;
-            int reference = pathK.at(0).at(startLayer);
-            foreach (QVector<int> path, pathK) {
-                if (path.at(startLayer) != reference)
-                {
-                    equal = false;
-                    break;
-                }
-            }
-            if (!equal)
-                break;
-
-            simplifiedIndex.append(reference);
-            ++startLayer;
-        }
-    }
+    static void runCascade(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                           std::vector<DotsCore> &cascade, QVector<int> &simplifiedIndex,
+                           QVector<QVector<int> > *levelIndex);
 
-protected:
-    // DOTS settings.
-    /**
-     * @brief lssdTh
-     */
-    double lssdTh;
-    double lssdUpperBound;
-    int maxVkSize;
-
-    // Input sequence.
-    QVector<double> ptx, pty, ptt;
-    QVector<int> ptIndex;
-    QVector<double> *pX, *pY, *pT;
-
-    // DOTS algorithm internal data.
-    QVector<double> xSum, ySum, tSum, x2Sum, y2Sum, t2Sum, xtSum, ytSum;
-    QVector<double> *pXSum, *pYSum, *pTSum, *pX2Sum, *pY2Sum, *pT2Sum, *pXTSum, *pYTSum;
-    QVector<double> vK,vL;
-    QVector<bool> terminated;
-    int numTerminated;
-    QVector< QVector<int> > pathK;
-    QVector<double> issed;
-    QVector<int> parents;
-
-    // Output sequence.
-    QVector<int> simplifiedIndex;
-    int inputCount;
-    int outputCount;
-
-    // Indicates if the input got EOF. No more data could be input after this flag was set.
-    bool finished;
-
-    bool isCascadeRoot;
+    /**
+     * @brief buildCascade constructs the cascade levels whose thresholds grow geometrically from about thStart to
+     * lssdThreshold.
+     * @param lssdThreshold is the LSSD threshold of the last level.
+     * @param thStart is the suggested LSSD threshold of the first level.
+     * @param thStep is the suggested ratio of thresholds of adjacent levels.
+     * @param cascade receives the cascade levels, the root first.
+     */
+    static void buildCascade(double lssdThreshold, double thStart, double thStep, std::vector<DotsCore> &cascade);
+
+    // The DOTS engine.
+    DotsCore core;
 
 signals:
 
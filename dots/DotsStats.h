@@ -0,0 +1,205 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief DotsStats.h defines the DotsStats class, the hot-path counters and histograms of DotsCore.
+  * @author caoweiquan322
+  */
+#ifndef DOTSSTATS_H
+#define DOTSSTATS_H
+
+#include<algorithm>
+#include<cstdio>
+#include<string>
+
+/**
+ * DOTS_STATS_RECORD compiles a statement that updates DotsStats only if DOTS_STATS is defined, e.g. by
+ * "qmake CONFIG+=dots_stats". Otherwise the instrumentation is removed and costs nothing.
+ */
+#ifdef DOTS_STATS
+#define DOTS_STATS_RECORD(statement) statement
+#else
+#define DOTS_STATS_RECORD(statement)
+#endif
+
+/**
+ * @brief The DotsHistogram class counts values in power-of-two buckets: bucket 0 holds 0, and bucket b holds values
+ * in [2^(b-1), 2^b).
+ */
+class DotsHistogram
+{
+public:
+    /**
+     * @brief BUCKETS is the number of buckets. The last one also holds all greater values.
+     */
+    static const int BUCKETS = 32;
+
+    /**
+     * @brief DotsHistogram constructs an empty histogram.
+     */
+    DotsHistogram()
+    {
+        clear();
+    }
+
+    /**
+     * @brief clear removes all values.
+     */
+    void clear()
+    {
+        for (int b=0; b<BUCKETS; ++b)
+            buckets[b] = 0;
+        total = 0;
+        maximum = 0;
+    }
+
+    /**
+     * @brief record counts a value. Negative values are counted as 0.
+     * @param value is the value.
+     */
+    inline void record(long long value)
+    {
+        if (value < 0)
+            value = 0;
+        int b = 0;
+        for (long long v=value; v>0 && b<BUCKETS-1; v>>=1)
+            ++b;
+        ++buckets[b];
+        ++total;
+        if (maximum < value)
+            maximum = value;
+    }
+
+    /**
+     * @brief merge adds the values of another histogram.
+     * @param other is the other histogram.
+     */
+    void merge(const DotsHistogram &other)
+    {
+        for (int b=0; b<BUCKETS; ++b)
+            buckets[b] += other.buckets[b];
+        total += other.total;
+        if (maximum < other.maximum)
+            maximum = other.maximum;
+    }
+
+    /**
+     * @brief percentile estimates a percentile by the upper bound of the bucket it falls in.
+     * @param p is the percentile in [0, 1].
+     * @return the estimated value.
+     */
+    long long percentile(double p) const
+    {
+        long long rank = static_cast<long long>(p*total+0.5), seen = 0;
+        for (int b=0; b<BUCKETS; ++b)
+        {
+            seen += buckets[b];
+            if (seen >= rank && seen > 0)
+                return (b == 0) ? 0 : std::min(maximum, (1LL << b)-1);
+        }
+        return maximum;
+    }
+
+    /**
+     * @brief toString formats the number of values, the median, the 99th percentile, the maximum and the non-empty
+     * buckets.
+     * @return the text.
+     */
+    std::string toString() const
+    {
+        char line[160];
+        snprintf(line, sizeof(line), "count=%lld p50<=%lld p99<=%lld max=%lld |", total, percentile(0.5),
+                 percentile(0.99), maximum);
+        std::string text = line;
+        for (int b=0; b<BUCKETS; ++b)
+        {
+            if (buckets[b] == 0)
+                continue;
+            snprintf(line, sizeof(line), " <%lld:%lld", (b == 0) ? 1LL : (1LL << b), buckets[b]);
+            text += line;
+        }
+        return text;
+    }
+
+    long long buckets[BUCKETS];
+    long long total;
+    long long maximum;
+};
+
+/**
+ * @brief The DotsStats class holds the counters and histograms DotsCore collects when built with DOTS_STATS. They
+ * show where the time of a trajectory goes, e.g. to choose maxVkSize and thresholds from data.
+ */
+class DotsStats
+{
+public:
+    /**
+     * @brief DotsStats constructs zeroed statistics.
+     */
+    DotsStats()
+    {
+        clear();
+    }
+
+    /**
+     * @brief clear zeroes all counters and histograms.
+     */
+    void clear()
+    {
+        lssdEvaluations = 0;
+        issedIterations = 0;
+        layers = 0;
+        pathTreeSteps = 0;
+        vKSize.clear();
+        vLSize.clear();
+        outputDelay.clear();
+    }
+
+    /**
+     * @brief merge adds the statistics of another simplifier, e.g. of another cascade level or trajectory.
+     * @param other is the other statistics.
+     */
+    void merge(const DotsStats &other)
+    {
+        lssdEvaluations += other.lssdEvaluations;
+        issedIterations += other.issedIterations;
+        layers += other.layers;
+        pathTreeSteps += other.pathTreeSteps;
+        vKSize.merge(other.vKSize);
+        vLSize.merge(other.vLSize);
+        outputDelay.merge(other.outputDelay);
+    }
+
+    /**
+     * @brief toString formats the statistics, one item per line.
+     * @return the text.
+     */
+    std::string toString() const
+    {
+        char line[160];
+        snprintf(line, sizeof(line), "LSSD evaluations: %lld\nISSED iterations: %lld\nlayers: %lld\n"
+                 "path tree steps: %lld\n", lssdEvaluations, issedIterations, layers, pathTreeSteps);
+        return line + ("|Vk|: " + vKSize.toString()) + ("\n|Vl|: " + vLSize.toString())
+                + ("\noutput delay: " + outputDelay.toString()) + "\n";
+    }
+
+    // Number of LSSD values calculated by the DAG search and minimizeISSED().
+    long long lssdEvaluations;
+    // Number of inner iterations of minimizeISSED().
+    long long issedIterations;
+    // Number of DAG layers, i.e. Vk/Vl swaps.
+    long long layers;
+    // Number of path tree nodes linked or pruned by updateVK().
+    long long pathTreeSteps;
+
+    // Sizes of Vk and Vl at each swap, and the number of input points between the newest input and each output.
+    DotsHistogram vKSize;
+    DotsHistogram vLSize;
+    DotsHistogram outputDelay;
+};
+
+#endif // DOTSSTATS_H
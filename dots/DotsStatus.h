@@ -0,0 +1,68 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief DotsStatus.h defines the DotsStatus codes returned by the exception-free API of DotsCore.
+  * @author caoweiquan322
+  */
+#ifndef DOTSSTATUS_H
+#define DOTSSTATUS_H
+
+/**
+ * DOTS_COLD marks a function that runs on error paths only, e.g. one that builds a message and throws. The compiler
+ * keeps it out of line and out of the hot loops calling it.
+ */
+#if defined(__GNUC__)
+#define DOTS_COLD __attribute__((noinline, cold))
+#elif defined(_MSC_VER)
+#define DOTS_COLD __declspec(noinline)
+#else
+#define DOTS_COLD
+#endif
+
+/**
+ * @brief The DotsStatus enum lists the results of the try*() methods of DotsCore. Each error corresponds to an
+ * exception the throwing methods raise in the same situation.
+ */
+enum DotsStatus
+{
+    // Success.
+    DOTS_OK = 0,
+    // Feeding after finish(). Call resetInternalData() first.
+    DOTS_ERROR_FINISHED,
+    // Feeding data to a cascade level that is not the root. Use feedIndex() instead.
+    DOTS_ERROR_NOT_CASCADE_ROOT,
+    // Feeding an index to the cascade root. Use feedData() instead.
+    DOTS_ERROR_CASCADE_ROOT,
+    // An index out of the valid range.
+    DOTS_ERROR_OUT_OF_RANGE
+};
+
+/**
+ * @brief dotsStatusMessage describes a status code.
+ * @param status is the status code.
+ * @return the description.
+ */
+inline const char *dotsStatusMessage(DotsStatus status)
+{
+    switch (status)
+    {
+    case DOTS_OK:
+        return "Success.";
+    case DOTS_ERROR_FINISHED:
+        return "Feeding data is NOT allowed after the simplifier finished. Suggest calling resetInternalData() first.";
+    case DOTS_ERROR_NOT_CASCADE_ROOT:
+        return "We can only feed index to non-root simplifier. Try feedIndex() instead.";
+    case DOTS_ERROR_CASCADE_ROOT:
+        return "We can only feed data to the cascade root simplifier. Try feedData() instead.";
+    case DOTS_ERROR_OUT_OF_RANGE:
+        return "Index is out of range.";
+    }
+    return "Unknown status.";
+}
+
+#endif // DOTSSTATUS_H
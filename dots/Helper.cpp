@@ -6,14 +6,16 @@
 
 #include "Helper.h"
 #include "DotsException.h"
+#include"TrajectoryReader.h"
+#include"BinaryStream.h"
+#include"ColumnCodec.h"
 #include<QString>
 #include<QFile>
-#include<QDateTime>
 #include<QVector>
 #include<QtMath>
 
-const QString Helper::MOPSI_DATETIME_FORMAT("yyyy-MM-ddHH:mm:ss");
 const double Helper::SCALE_FACTOR_PRECISION = 1e-4;
+const char *const Helper::BINARY_SUFFIX = ".dtraj";
 const double Helper::ZERO = 0.0;
 const double Helper::INF = 1.0/Helper::ZERO;
 
@@ -45,105 +47,99 @@ void Helper::checkPositive(QString name, double value)
     }
 }
 
-void Helper::parseMOPSI(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t)
+void Helper::parseMOPSI(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                        TrajectoryFrame *frame)
 {
-    // Check if file name is null or empty.
-    Helper::checkNotNullNorEmpty("fileName", fileName);
-    try
-    {
-        // Open file in TEXT mode.
-        QFile file(fileName.trimmed());
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-            DotsException(QString("Open file %1 error.").arg(fileName)).raise();
+    parseText(fileName, TrajectoryReader::FORMAT_MOPSI, x, y, NULL, t, frame);
+}
 
-        QVector<double> longitude, latitude;
-        x.clear();
-        y.clear();
-        t.clear();
-        while(!file.atEnd())
-        {
-            // Read the file line by line.
-            QByteArray line = file.readLine().trimmed();
-            if(line.isEmpty())
-                continue;
-            auto parts = line.split(' ');
+void Helper::parseMOPSI2(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                         TrajectoryFrame *frame)
+{
+    parseText(fileName, TrajectoryReader::FORMAT_MOPSI2, x, y, NULL, t, frame);
+}
 
-            // In case where the line is malformed.
-            if(parts.count() != 4)
-            {
-                DotsException("Malformed line found.").raise();
-            }
+void Helper::parseGeoLife(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                          TrajectoryFrame *frame)
+{
+    parseText(fileName, TrajectoryReader::FORMAT_GEOLIFE, x, y, NULL, t, frame);
+}
 
-            // Store the parsed data without cleaning it.
-            double timestamp = (double)QDateTime::fromString(parts[2]+parts[3], MOPSI_DATETIME_FORMAT).toTime_t();
-            if (!t.empty() && timestamp-t.last() < 1e-15) // Duplicated time point.
-                continue;
-            latitude.append(parts[0].toDouble());
-            longitude.append(parts[1].toDouble());
-            t.append(timestamp);
-        }
-        // Do mercator projection on the parsed longitude/latitude.
-        mercatorProject(longitude, latitude, x, y);
+void Helper::parseGeoLife(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &z,
+                          QVector<double> &t, TrajectoryFrame *frame)
+{
+    parseText(fileName, TrajectoryReader::FORMAT_GEOLIFE, x, y, &z, t, frame);
+}
 
-        // Normalize data by first value of each array.
-        Helper::normalizeData(x, true);
-        Helper::normalizeData(y, true);
-        Helper::normalizeData(t, false);
-    }
-    catch (DotsException &e)
-    {
-        e.raise();
-    }
-    catch (QException &)
-    {
-        DotsException("Error occured when parsing trajectory file.").raise();
-    }
+void Helper::parseMitScv(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                         TrajectoryFrame *frame)
+{
+    parseText(fileName, TrajectoryReader::FORMAT_MIT_SCV, x, y, NULL, t, frame);
 }
 
-void Helper::parseMOPSI2(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t)
+void Helper::parseText(QString fileName, TrajectoryReader::Format format, QVector<double> &x, QVector<double> &y,
+                       QVector<double> *z, QVector<double> &t, TrajectoryFrame *frame)
 {
     // Check if file name is null or empty.
     Helper::checkNotNullNorEmpty("fileName", fileName);
     try
     {
-        // Open file in TEXT mode.
-        QFile file(fileName.trimmed());
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-            DotsException(QString("Open file %1 error.").arg(fileName)).raise();
+        TrajectoryReader reader(fileName, format);
+        bool geographic = reader.isGeographic();
 
+        // Geographic positions are collected as longitude/latitude and projected afterwards.
         QVector<double> longitude, latitude;
+        QVector<double> &px = geographic ? longitude : x;
+        QVector<double> &py = geographic ? latitude : y;
+        int lineCount = reader.lineCount();
+        reserveOutput(lineCount, px, py, t);
         x.clear();
         y.clear();
-        t.clear();
-        while(!file.atEnd())
+        if (z != NULL)
+        {
+            z->clear();
+            z->reserve(lineCount);
+        }
+        int firstValidAltitude = -1;
+        TrajectoryRecord record;
+        while (reader.next(record))
         {
-            // Read the file line by line.
-            QByteArray line = file.readLine().trimmed();
-            if(line.isEmpty())
+            px.append(record.x);
+            py.append(record.y);
+            t.append(record.t);
+            if (z == NULL)
                 continue;
-            auto parts = line.split(' ');
 
-            // In case where the line is malformed.
-            if(parts.count() != 4)
+            // An invalid altitude repeats the previous valid altitude.
+            if (record.hasZ)
             {
-                DotsException("Malformed line found.").raise();
+                if (firstValidAltitude < 0)
+                    firstValidAltitude = z->count();
+                z->append(record.z);
             }
-
-            // Store the parsed data without cleaning it.
-            double timestamp = parts[2].toDouble()/1000.0;
-            if (!t.empty() && timestamp-t.last() < 1e-15) // Duplicated time point.
-                continue;
-            latitude.append(parts[0].toDouble());
-            longitude.append(parts[1].toDouble());
-            t.append(timestamp);
+            else
+                z->append(z->isEmpty() ? 0 : z->last());
         }
+        if (z != NULL)
+        {
+            // Leading invalid altitudes repeat the first valid one.
+            for (int k=0; k<firstValidAltitude; ++k)
+                (*z)[k] = (*z)[firstValidAltitude];
+        }
+
         // Do mercator projection on the parsed longitude/latitude.
-        mercatorProject(longitude, latitude, x, y);
+        double scaleFactor = 0;
+        if (geographic)
+            mercatorProject(longitude, latitude, x, y, &scaleFactor);
 
         // Normalize data by first value of each array.
-        Helper::normalizeData(x, true);
-        Helper::normalizeData(y, true);
-        Helper::normalizeData(t, false);
+        double offsetX = Helper::normalizeData(x, true);
+        double offsetY = Helper::normalizeData(y, true);
+        if (z != NULL)
+            Helper::normalizeData(*z, true);
+        double offsetT = Helper::normalizeData(t, false);
+        if (frame != NULL)
+            *frame = TrajectoryFrame(scaleFactor, offsetX, offsetY, offsetT);
     }
     catch (DotsException &e)
     {
@@ -155,161 +151,204 @@ void Helper::parseMOPSI2(QString fileName, QVector<double> &x, QVector<double> &
     }
 }
 
-void Helper::parseGeoLife(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t)
+void Helper::parseTrajectory(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                             TrajectoryFrame *frame)
+{
+    if (fileName.endsWith(BINARY_SUFFIX)) // Converted by convertToBinary().
+        Helper::parseBinary(fileName, x, y, t, frame);
+    else
+        Helper::parseText(fileName, TrajectoryReader::formatOf(fileName), x, y, NULL, t, frame);
+}
+
+void Helper::writeBinary(QString fileName, const QVector<double> &x, const QVector<double> &y,
+                         const QVector<double> &t, const TrajectoryFrame &frame, double xyResolution,
+                         double tResolution)
+{
+    Helper::checkNotNullNorEmpty("fileName", fileName);
+    Helper::checkIntEqual(x.count(), y.count());
+    Helper::checkIntEqual(x.count(), t.count());
+    Helper::checkPositive("xyResolution", xyResolution);
+    Helper::checkPositive("tResolution", tResolution);
+
+    // Encode each column into a byte string of its own, as the header records their sizes.
+    int pointCount = x.count();
+    std::string columns[3];
+    if (!ColumnCodec::encode(x.constData(), pointCount, xyResolution, columns[0])
+            || !ColumnCodec::encode(y.constData(), pointCount, xyResolution, columns[1])
+            || !ColumnCodec::encode(t.constData(), pointCount, tResolution, columns[2]))
+        DotsException("The trajectory has values that are not finite or too large for the resolution.").raise();
+
+    std::string header;
+    BinaryWriter writer(header);
+    writer.write(BINARY_MAGIC);
+    writer.write(BINARY_VERSION);
+    writer.write(pointCount);
+    writer.write(frame.scaleFactor);
+    writer.write(frame.offsetX);
+    writer.write(frame.offsetY);
+    writer.write(frame.offsetT);
+    writer.write(xyResolution);
+    writer.write(tResolution);
+    for (int k=0; k<3; ++k)
+        writer.write(static_cast<qint64>(columns[k].size()));
+
+    QFile file(fileName.trimmed());
+    if (!file.open(QIODevice::WriteOnly))
+        DotsException(QString("Open file %1 error.").arg(file.fileName())).raise();
+    bool written = (file.write(header.data(), header.size()) == static_cast<qint64>(header.size()));
+    for (int k=0; k<3 && written; ++k)
+        written = (file.write(columns[k].data(), columns[k].size()) == static_cast<qint64>(columns[k].size()));
+    if (!written)
+        DotsException(QString("Write file %1 error.").arg(file.fileName())).raise();
+}
+
+void Helper::parseBinary(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                         TrajectoryFrame *frame)
 {
     // Check if file name is null or empty.
     Helper::checkNotNullNorEmpty("fileName", fileName);
+
+    // Map the file and decode it in place.
+    QFile file(fileName.trimmed());
+    QByteArray buffer;
+    const char *begin, *end;
+    mapFile(file, buffer, begin, end);
+
     try
     {
-        // Open file in TEXT mode.
-        QFile file(fileName.trimmed());
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-            DotsException(QString("Open file %1 error.").arg(fileName)).raise();
-
-        QVector<double> longitude, latitude;
-        x.clear();
-        y.clear();
-        t.clear();
-        int numLine = 0;
-        while(!file.atEnd())
+        BinaryReader reader(begin, end-begin);
+        if (reader.read<int>() != BINARY_MAGIC || reader.read<int>() != BINARY_VERSION)
+            DotsException("Not a binary trajectory file, or one of an unsupported version.").raise();
+        int pointCount = reader.read<int>();
+        TrajectoryFrame fileFrame;
+        fileFrame.scaleFactor = reader.read<double>();
+        fileFrame.offsetX = reader.read<double>();
+        fileFrame.offsetY = reader.read<double>();
+        fileFrame.offsetT = reader.read<double>();
+        double resolutions[3];
+        resolutions[0] = resolutions[1] = reader.read<double>();
+        resolutions[2] = reader.read<double>();
+        qint64 columnSizes[3];
+        for (int k=0; k<3; ++k)
+            columnSizes[k] = reader.read<qint64>();
+
+        // Every value takes a byte at least, which bounds the point count before allocating the arrays.
+        QVector<double> *columns[3] = {&x, &y, &t};
+        for (int k=0; k<3; ++k)
         {
-            // Read the file line by line.
-            QByteArray line = file.readLine().trimmed();
-            ++numLine;
-            if (numLine<=6)
-                continue;
-            if(line.isEmpty())
-                continue;
-            auto parts = line.split(',');
-
-            // In case where the line is malformed.
-            if(parts.count() != 7)
-            {
-                DotsException("Malformed line found.").raise();
-            }
-
-            // Store the parsed data without cleaning it.
-            double timestamp = parts[4].toDouble();
-            timestamp *= (24*3600);
-            if (!t.empty() && timestamp-t.last() < 1e-15) // Duplicated time point.
-                continue;
-            latitude.append(parts[0].toDouble());
-            longitude.append(parts[1].toDouble());
-            t.append(timestamp);
+            if (pointCount < 0 || columnSizes[k] < pointCount)
+                DotsException("Corrupted or truncated binary trajectory file.").raise();
+            const char *column = reader.skip(static_cast<size_t>(columnSizes[k]));
+            const char *columnEnd = column+columnSizes[k];
+            columns[k]->resize(pointCount);
+            if (ColumnCodec::decode(column, columnEnd, pointCount, resolutions[k], columns[k]->data()) != columnEnd)
+                DotsException("Corrupted or truncated binary trajectory file.").raise();
         }
-        // Do mercator projection on the parsed longitude/latitude.
-        mercatorProject(longitude, latitude, x, y);
-
-        // Normalize data by first value of each array.
-        Helper::normalizeData(x, true);
-        Helper::normalizeData(y, true);
-        Helper::normalizeData(t, false);
+        if (frame != NULL)
+            *frame = fileFrame;
     }
     catch (DotsException &e)
     {
         e.raise();
     }
-    catch (QException &)
+    catch (const std::exception &)
     {
-        DotsException("Error occured when parsing trajectory file.").raise();
+        DotsException("Corrupted or truncated binary trajectory file.").raise();
     }
 }
 
-void Helper::parseMitScv(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t)
+void Helper::convertToBinary(QString textFileName, QString binaryFileName, double xyResolution, double tResolution)
 {
-    // Check if file name is null or empty.
-    Helper::checkNotNullNorEmpty("fileName", fileName);
-    try
+    QVector<double> x, y, t;
+    TrajectoryFrame frame;
+    parseTrajectory(textFileName, x, y, t, &frame);
+    writeBinary(binaryFileName, x, y, t, frame, xyResolution, tResolution);
+}
+
+void Helper::mapFile(QFile &file, QByteArray &buffer, const char *&begin, const char *&end)
+{
+    // Open file in binary mode, as the scanner trims the '\r' of "\r\n" line ends itself.
+    if (!file.open(QIODevice::ReadOnly))
+        DotsException(QString("Open file %1 error.").arg(file.fileName())).raise();
+
+    // The mapping is released when the file is closed.
+    qint64 size = file.size();
+    const uchar *data = (size > 0) ? file.map(0, size) : NULL;
+    if (data != NULL)
     {
-        // Open file in TEXT mode.
-        QFile file(fileName.trimmed());
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-            DotsException(QString("Open file %1 error.").arg(fileName)).raise();
+        begin = reinterpret_cast<const char *>(data);
+        end = begin+size;
+        return;
+    }
 
-        x.clear();
-        y.clear();
-        t.clear();
-        int numLine = 0;
-        while(!file.atEnd())
-        {
-            // Read the file line by line.
-            QByteArray line = file.readLine().trimmed();
-            ++numLine;
-            if(line.isEmpty())
-                continue;
-            auto parts = line.split(',');
+    // Fall back to reading empty files and devices that could not be mapped.
+    buffer = file.readAll();
+    begin = buffer.constData();
+    end = begin+buffer.size();
+}
 
-            // In case where the line is malformed.
-            if(parts.count() != 3)
-            {
-                DotsException("Malformed line found.").raise();
-            }
+void Helper::reserveOutput(int n, QVector<double> &a, QVector<double> &b, QVector<double> &c)
+{
+    a.clear();
+    b.clear();
+    c.clear();
+    a.reserve(n);
+    b.reserve(n);
+    c.reserve(n);
+}
 
-            // Store the parsed data without cleaning it.
-            double timestamp = parts[2].toDouble();
-            if (!t.empty() && timestamp-t.last() < 1e-15) // Duplicated time point.
-                continue;
-            x.append(parts[0].toDouble());
-            y.append(parts[1].toDouble());
-            t.append(timestamp);
-        }
-        // Need no mercator projection.
+double Helper::toDouble(const TextField &field)
+{
+    double value;
+    if (TextScanner::parseDouble(field, value))
+        return value;
 
-        // Normalize data by first value of each array.
-        Helper::normalizeData(x, true);
-        Helper::normalizeData(y, true);
-        Helper::normalizeData(t, false);
-    }
-    catch (DotsException &e)
-    {
-        e.raise();
-    }
-    catch (QException &)
+    // Leave other forms to Qt, so that the values are the same as those of QByteArray::toDouble().
+    return QByteArray::fromRawData(field.begin, field.length()).toDouble();
+}
+
+double Helper::mercatorScaleFactor(const double *latitude, int n)
+{
+    // Calculate the average scale factor.
+    double sf = 0;
+    for(int i=0; i<n; ++i)
     {
-        DotsException("Error occured when parsing trajectory file.").raise();
+        sf += 1.0/qCos(qDegreesToRadians(latitude[i]));
     }
+    sf/=n;
+    return qRound(sf/SCALE_FACTOR_PRECISION)*SCALE_FACTOR_PRECISION;
 }
 
 // Problem with points whose latitude nears pi/2 was fixed.
 void Helper::mercatorProject(QVector<double> &longitude, QVector<double> &latitude, QVector<double> &x,
-                                     QVector<double> &y)
+                                     QVector<double> &y, double *scaleFactor)
 {
     // Check if input position array is of the same size.
     Helper::checkIntEqual(longitude.count(), latitude.count());
     try
     {
-        // Clear output variables.
-        x.clear();
-        y.clear();
-        // Define the constant MERCATOR projection limits.
-        const double MERCATOR_LATITUDE_LB = 2.5*2.0-90.0;
-        const double MERCATOR_LATITUDE_UB = 87.5*2.0-90.0;
         int pointCount = longitude.count();
+        if (scaleFactor != NULL)
+            *scaleFactor = 1.0;
         if(pointCount<=0)
         {
+            // Clear output variables.
+            x.clear();
+            y.clear();
             return;
         }
 
-        // Calculate the average scale factor.
-        const double earthRadius = 6378100.0;
-        double rx, ry, sf=0;// Longitude/latitude in radian.
-        for(int i=0; i<pointCount; ++i)
-        {
-            sf += 1.0/qCos(qDegreesToRadians(latitude[i]));
-        }
-        sf/=pointCount;
-        sf = qRound(sf/SCALE_FACTOR_PRECISION)*SCALE_FACTOR_PRECISION;
-
-        // Do projection.
-        for(int i=0; i<pointCount; ++i)
-        {
-            rx = qDegreesToRadians(longitude[i]);
-            ry = qDegreesToRadians(Helper::limitVal(latitude[i], MERCATOR_LATITUDE_LB, MERCATOR_LATITUDE_UB));
-            ry = qLn(qFabs(qTan(ry)+1.0/qCos(ry)));
-
-            x.append(rx*earthRadius/sf);
-            y.append(ry*earthRadius/sf);
-        }
+        double sf = mercatorScaleFactor(latitude.constData(), pointCount);
+        if (scaleFactor != NULL)
+            *scaleFactor = sf;
+
+        // Do projection on whole columns. The outputs are sized before taking any pointers, as they may be the
+        // inputs.
+        x.resize(pointCount);
+        y.resize(pointCount);
+        double *px = x.data();
+        double *py = y.data();
+        MercatorKernel::project(longitude.constData(), latitude.constData(), pointCount, sf, px, py);
     }
     catch(DotsException &e)
     {
@@ -321,11 +360,51 @@ void Helper::mercatorProject(QVector<double> &longitude, QVector<double> &latitu
     }
 }
 
-void Helper::normalizeData(QVector<double> &x, bool byMean)
+void Helper::mercatorUnproject(QVector<double> &x, QVector<double> &y, double scaleFactor,
+                               QVector<double> &longitude, QVector<double> &latitude)
+{
+    Helper::checkIntEqual(x.count(), y.count());
+    Helper::checkPositive("scaleFactor", scaleFactor);
+
+    int pointCount = x.count();
+    longitude.resize(pointCount);
+    latitude.resize(pointCount);
+    double *pLongitude = longitude.data();
+    double *pLatitude = latitude.data();
+    MercatorKernel::unproject(x.constData(), y.constData(), pointCount, scaleFactor, pLongitude, pLatitude);
+}
+
+void Helper::splitByGaps(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                         double maxTimeGap, double maxDistanceGap, QVector<int> &segmentStarts)
+{
+    Helper::checkIntEqual(x.count(), y.count());
+    Helper::checkIntEqual(x.count(), t.count());
+    if (maxTimeGap < 0 || maxDistanceGap < 0)
+        DotsException("The maximum gaps must not be negative.").raise();
+
+    segmentStarts.clear();
+    int pointCount = x.count();
+    if (pointCount <= 0)
+        return;
+
+    // Compare squared distances to avoid a square root per point.
+    double maxDistanceGap2 = maxDistanceGap*maxDistanceGap;
+    segmentStarts.append(0);
+    for (int i=1; i<pointCount; ++i)
+    {
+        double dx = x.at(i)-x.at(i-1);
+        double dy = y.at(i)-y.at(i-1);
+        if ((maxTimeGap > 0 && t.at(i)-t.at(i-1) > maxTimeGap)
+                || (maxDistanceGap > 0 && dx*dx+dy*dy > maxDistanceGap2))
+            segmentStarts.append(i);
+    }
+}
+
+double Helper::normalizeData(QVector<double> &x, bool byMean)
 {
     // Check if array is empty.
     if (x.empty())
-        return;
+        return 0;
 
     // Get the calibrate value.
     double cal = 0;
@@ -346,4 +425,5 @@ void Helper::normalizeData(QVector<double> &x, bool byMean)
     {
         x[i] = x[i]-cal;
     }
+    return cal;
 }
@@ -10,6 +10,29 @@
 #include <QObject>
 #include<QVector>
 #include<QtMath>
+#include"TextScanner.h"
+#include"TrajectoryReader.h"
+#include"MercatorKernel.h"
+
+/**
+ * @brief The TrajectoryFrame class records how the parsers turned the positions and timestamps of a trajectory file
+ * into the values they return, so that the original values can be recovered, e.g. from a binary trajectory file.
+ * A returned x equals the projected x minus offsetX, and likewise for y and t.
+ */
+class TrajectoryFrame {
+public:
+    TrajectoryFrame(double scaleFactor = 0, double offsetX = 0, double offsetY = 0, double offsetT = 0) :
+        scaleFactor(scaleFactor), offsetX(offsetX), offsetY(offsetY), offsetT(offsetT)
+    {
+    }
+
+    // The scale factor of the mercator projection, or 0 if the positions were not projected.
+    double scaleFactor;
+    // The values subtracted by normalization.
+    double offsetX;
+    double offsetY;
+    double offsetT;
+};
 
 /**
  * @brief The Helper class provides some utilities for the package. E.g. parameter checking, logging, etc.
@@ -72,9 +95,12 @@ public:
      * @param x is the x values of trajectory points.
      * @param y is the y values of trajectory points.
      * @param t is the timestamps of trajectory points.
+     * @param frame receives the projection and normalization of the points, unless it is NULL.
      */
-    static void parseMOPSI(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t);
-    static void parseMOPSI2(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t);
+    static void parseMOPSI(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                           TrajectoryFrame *frame = NULL);
+    static void parseMOPSI2(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                            TrajectoryFrame *frame = NULL);
 
     /**
      * @brief parseGeoLife parses a GeoLife data file. Reference to Dr. Yu Zheng in MRA (Microsoft Research in Asia)
@@ -83,20 +109,166 @@ public:
      * @param x is the x values of trajectory points.
      * @param y is the y values of trajectory points.
      * @param t is the timestamps of trajectory points.
+     * @param frame receives the projection and normalization of the points, unless it is NULL.
+     */
+    static void parseGeoLife(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                             TrajectoryFrame *frame = NULL);
+
+    /**
+     * @brief parseGeoLife parses a GeoLife data file together with the altitude of the points, e.g. for simplifying
+     * by DotsSimplifier::batchDots3DByIndex(). Altitudes are converted from feet to meters, and invalid ones (-777) are
+     * replaced by the nearest valid altitude before them, or after them at the beginning of the file.
+     * @param fileName is the file name of GeoLife format.
+     * @param x is the x values of trajectory points.
+     * @param y is the y values of trajectory points.
+     * @param z is the altitudes of trajectory points in meters.
+     * @param t is the timestamps of trajectory points.
+     * @param frame receives the projection and normalization of the points, unless it is NULL.
+     */
+    static void parseGeoLife(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &z,
+                             QVector<double> &t, TrajectoryFrame *frame = NULL);
+
+    static void parseMitScv(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                            TrajectoryFrame *frame = NULL);
+
+    /**
+     * @brief parseTrajectory parses a trajectory file of any supported format, chosen by the file name suffix: ".txt"
+     * for MOPSI, ".plt" for GeoLife, ".csv" for MIT Single Camera View, BINARY_SUFFIX for binary trajectory files and
+     * MOPSI2 otherwise.
+     * @param fileName is the file name.
+     * @param x is the x values of trajectory points.
+     * @param y is the y values of trajectory points.
+     * @param t is the timestamps of trajectory points.
+     * @param frame receives the projection and normalization of the points, unless it is NULL.
+     */
+    static void parseTrajectory(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                                TrajectoryFrame *frame = NULL);
+
+    /**
+     * @brief writeBinary writes a parsed trajectory as a binary trajectory file, which parseBinary() reloads without
+     * parsing, projecting or normalizing it again.
+     *
+     * The file has a header of the point count, the frame and the resolutions, followed by the x, y and t columns,
+     * each encoded by ColumnCodec. Values are stored as multiples of the resolutions, so they are reloaded with an
+     * error of at most half the resolution. The file is in host byte order, like DOTS snapshots.
+     * @param fileName is the file name.
+     * @param x is the x values of trajectory points.
+     * @param y is the y values of trajectory points.
+     * @param t is the timestamps of trajectory points.
+     * @param frame is the projection and normalization of the points.
+     * @param xyResolution is the resolution of the x and y values, 1 mm by default.
+     * @param tResolution is the resolution of the timestamps, 1 ms by default.
      */
-    static void parseGeoLife(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t);
+    static void writeBinary(QString fileName, const QVector<double> &x, const QVector<double> &y,
+                            const QVector<double> &t, const TrajectoryFrame &frame = TrajectoryFrame(),
+                            double xyResolution = 1e-3, double tResolution = 1e-3);
 
-    static void parseMitScv(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t);
+    /**
+     * @brief parseBinary reads a binary trajectory file written by writeBinary(). The file is mapped into memory and
+     * its columns are decoded straight into the output arrays.
+     * @param fileName is the file name.
+     * @param x is the x values of trajectory points.
+     * @param y is the y values of trajectory points.
+     * @param t is the timestamps of trajectory points.
+     * @param frame receives the projection and normalization of the points, unless it is NULL.
+     */
+    static void parseBinary(QString fileName, QVector<double> &x, QVector<double> &y, QVector<double> &t,
+                            TrajectoryFrame *frame = NULL);
+
+    /**
+     * @brief convertToBinary converts a trajectory file of any format parseTrajectory() supports to a binary
+     * trajectory file.
+     * @param textFileName is the file name of the trajectory file.
+     * @param binaryFileName is the file name of the binary trajectory file.
+     * @param xyResolution is the resolution of the x and y values.
+     * @param tResolution is the resolution of the timestamps.
+     */
+    static void convertToBinary(QString textFileName, QString binaryFileName, double xyResolution = 1e-3,
+                                double tResolution = 1e-3);
+
+    /**
+     * @brief BINARY_SUFFIX is the file name suffix of binary trajectory files.
+     */
+    static const char *const BINARY_SUFFIX;
 
     /**
-     * @brief mercatorProject does mercator projection on the longitude/latitude pairs.
+     * @brief mapFile opens a file and maps it into memory for the parsers to scan in place. Files that could not be
+     * mapped are read into buffer instead.
+     * @param file is the file, which must not be open yet. The mapping lives until it is closed or destroyed.
+     * @param buffer receives the content if the file was not mapped.
+     * @param begin receives the first character of the content.
+     * @param end receives one past the last character of the content.
+     */
+    static void mapFile(QFile &file, QByteArray &buffer, const char *&begin, const char *&end);
+
+    /**
+     * @brief toDouble converts a field of a trajectory file. Plain decimals are converted by TextScanner, and other
+     * forms by QByteArray::toDouble(), so the value is always the one QByteArray::toDouble() gives.
+     * @param field is the field.
+     * @return the value, or 0 if the field is not a number.
+     */
+    static double toDouble(const TextField &field);
+
+    /**
+     * @brief mercatorScaleFactor calculates the scale factor of the mercator projection of positions, the mean of
+     * 1/cos(latitude) rounded to SCALE_FACTOR_PRECISION.
+     * @param latitude is the latitude of positions.
+     * @param n is the number of positions, which must be positive.
+     * @return the scale factor.
+     */
+    static double mercatorScaleFactor(const double *latitude, int n);
+
+    /**
+     * @brief mercatorProjectPoint does mercator projection on a longitude/latitude pair with a given scale factor,
+     * with the same results as mercatorProject(). See MercatorKernel.
+     * @param longitude is the longitude of the position.
+     * @param latitude is the latitude of the position.
+     * @param scaleFactor is the scale factor, e.g. calculated by mercatorScaleFactor().
+     * @param x receives the x value of the position.
+     * @param y receives the y value of the position.
+     */
+    static inline void mercatorProjectPoint(double longitude, double latitude, double scaleFactor, double &x,
+                                            double &y)
+    {
+        MercatorKernel::projectPoint(longitude, latitude, scaleFactor, x, y);
+    }
+
+    /**
+     * @brief mercatorProject does mercator projection on the longitude/latitude pairs by MercatorKernel. The
+     * positions may be projected in place, i.e. x and y may be longitude and latitude.
      * @param longitude is the longitude of positions.
      * @param latitude is the latitude of positions.
      * @param x is the x values of positions.
      * @param y is the y values of positions.
+     * @param scaleFactor receives the scale factor of the projection, unless it is NULL.
      */
     static void mercatorProject(QVector<double> &longitude, QVector<double> &latitude, QVector<double> &x,
-                                QVector<double> &y);
+                                QVector<double> &y, double *scaleFactor = NULL);
+
+    /**
+     * @brief mercatorUnproject is the inverse of mercatorProject(), e.g. for writing simplified points back as
+     * longitude/latitude pairs. The positions may be unprojected in place.
+     * @param x is the x values of positions.
+     * @param y is the y values of positions.
+     * @param scaleFactor is the scale factor of the projection.
+     * @param longitude is the longitude of positions.
+     * @param latitude is the latitude of positions.
+     */
+    static void mercatorUnproject(QVector<double> &x, QVector<double> &y, double scaleFactor,
+                                  QVector<double> &longitude, QVector<double> &latitude);
+
+    /**
+     * @brief splitByGaps splits a trajectory at recording gaps, i.e. between consecutive points that are further apart
+     * in time or in space than allowed.
+     * @param x is the x values of trajectory points.
+     * @param y is the y values of trajectory points.
+     * @param t is the timestamps of trajectory points.
+     * @param maxTimeGap is the maximum time between consecutive points of a segment, or 0 for no bound.
+     * @param maxDistanceGap is the maximum distance between consecutive points of a segment, or 0 for no bound.
+     * @param segmentStarts receives the index of the first point of each segment. It is empty for an empty trajectory.
+     */
+    static void splitByGaps(const QVector<double> &x, const QVector<double> &y, const QVector<double> &t,
+                            double maxTimeGap, double maxDistanceGap, QVector<int> &segmentStarts);
 
     /**
      * @brief normalizeData normalizes data array by sutracts values by the mean or the first value. Method behavior
@@ -104,8 +276,9 @@ public:
      * @param x is the data array
      * @param byMean specifies by which value to subtracts each element. Set it to true (DEFAULT) if use the mean
      * value and false if use the first value.
+     * @return the value subtracted from each element, or 0 if the array is empty.
      */
-    static void normalizeData(QVector<double> &x, bool byMean = true);
+    static double normalizeData(QVector<double> &x, bool byMean = true);
 
     /**
      * @brief range generates a vector that increasingly from value "from" to value "to" with increasing step "step".
@@ -219,15 +392,34 @@ public:
 
 protected:
     /**
-     * @brief MOPSI_DATETIME_FORMAT represents the datetime format of MOPSI dataset.
+     * @brief parseText parses a trajectory text file by TrajectoryReader, then projects and normalizes the points.
+     * @param fileName is the file name.
+     * @param format is the format of the file.
+     * @param x is the x values of trajectory points.
+     * @param y is the y values of trajectory points.
+     * @param z receives the altitudes of trajectory points in meters, unless it is NULL. See parseGeoLife().
+     * @param t is the timestamps of trajectory points.
+     * @param frame receives the projection and normalization of the points, unless it is NULL.
      */
-    static const QString MOPSI_DATETIME_FORMAT;
+    static void parseText(QString fileName, TrajectoryReader::Format format, QVector<double> &x,
+                          QVector<double> &y, QVector<double> *z, QVector<double> &t, TrajectoryFrame *frame);
+
+    /**
+     * @brief reserveOutput clears three arrays and reserves space for n values in each of them.
+     */
+    static void reserveOutput(int n, QVector<double> &a, QVector<double> &b, QVector<double> &c);
 
     /**
      * @brief SCALE_FACTOR_PRECISION represents the precision for mercator projection.
      */
     static const double SCALE_FACTOR_PRECISION;
 
+    /**
+     * @brief BINARY_MAGIC and BINARY_VERSION head every binary trajectory file.
+     */
+    static const int BINARY_MAGIC = 0x4a525444;
+    static const int BINARY_VERSION = 1;
+
     static const double ZERO;
     static const double INF;
 
@@ -0,0 +1,384 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief LssdKernel.h defines the batched LSSD kernel used by the DAG search of DOTS.
+  * @author caoweiquan322
+  */
+#ifndef LSSDKERNEL_H
+#define LSSDKERNEL_H
+
+#include<vector>
+#if defined(__AVX512F__) || defined(__AVX__)
+#include<immintrin.h>
+#endif
+
+/**
+ * @brief The LssdPointT class holds what LSSD needs to know about one end of a segment: the position and timestamp
+ * of the point, and the prefix sums together with their index. N is the number of spatial axes, and x[a] is the
+ * position along axis a.
+ *
+ * For the first point of a segment the prefix sums are taken AT the point. For the last point of a segment they are
+ * taken at the PRECEDING point, so that differences of the two cover exactly the points between them. Every prefix sum
+ * is the sum of its high part and the low part of the same name with suffix Lo (see PrefixStatisticsT).
+ */
+template<int N>
+class LssdPointT {
+public:
+    double index;
+    double x[N], t;
+    double xSum[N], tSum, x2Sum[N], t2Sum, xtSum[N];
+    double xSumLo[N], tSumLo, x2SumLo[N], t2SumLo, xtSumLo[N];
+};
+
+/**
+ * @brief The LssdFrontierT class stores the first points of a set of candidate segments in structure-of-arrays
+ * layout, so that LSSD of one last point against all of them could be evaluated in SIMD registers.
+ */
+template<int N>
+class LssdFrontierT {
+public:
+    /**
+     * @brief resize changes the number of candidates in the frontier.
+     * @param n is the number of candidates.
+     */
+    inline void resize(int n)
+    {
+        index.resize(n);
+        t.resize(n);
+        tSum.resize(n);
+        t2Sum.resize(n);
+        tSumLo.resize(n);
+        t2SumLo.resize(n);
+        for (int a=0; a<N; ++a)
+        {
+            x[a].resize(n);
+            xSum[a].resize(n);
+            x2Sum[a].resize(n);
+            xtSum[a].resize(n);
+            xSumLo[a].resize(n);
+            x2SumLo[a].resize(n);
+            xtSumLo[a].resize(n);
+        }
+    }
+
+    /**
+     * @brief count retrieves the number of candidates in the frontier.
+     * @return the number of candidates.
+     */
+    inline int count() const
+    {
+        return static_cast<int>(index.size());
+    }
+
+    /**
+     * @brief set stores the k-th candidate.
+     * @param k is the position of the candidate.
+     * @param p is the candidate point.
+     */
+    inline void set(int k, const LssdPointT<N> &p)
+    {
+        index[k] = p.index;
+        t[k] = p.t;
+        tSum[k] = p.tSum;
+        t2Sum[k] = p.t2Sum;
+        tSumLo[k] = p.tSumLo;
+        t2SumLo[k] = p.t2SumLo;
+        for (int a=0; a<N; ++a)
+        {
+            x[a][k] = p.x[a];
+            xSum[a][k] = p.xSum[a];
+            x2Sum[a][k] = p.x2Sum[a];
+            xtSum[a][k] = p.xtSum[a];
+            xSumLo[a][k] = p.xSumLo[a];
+            x2SumLo[a][k] = p.x2SumLo[a];
+            xtSumLo[a][k] = p.xtSumLo[a];
+        }
+    }
+
+    /**
+     * @brief get retrieves the k-th candidate.
+     * @param k is the position of the candidate.
+     * @return the candidate point.
+     */
+    inline LssdPointT<N> get(int k) const
+    {
+        LssdPointT<N> p;
+        p.index = index[k];
+        p.t = t[k];
+        p.tSum = tSum[k];
+        p.t2Sum = t2Sum[k];
+        p.tSumLo = tSumLo[k];
+        p.t2SumLo = t2SumLo[k];
+        for (int a=0; a<N; ++a)
+        {
+            p.x[a] = x[a][k];
+            p.xSum[a] = xSum[a][k];
+            p.x2Sum[a] = x2Sum[a][k];
+            p.xtSum[a] = xtSum[a][k];
+            p.xSumLo[a] = xSumLo[a][k];
+            p.x2SumLo[a] = x2SumLo[a][k];
+            p.xtSumLo[a] = xtSumLo[a][k];
+        }
+        return p;
+    }
+
+    std::vector<double> index, t, tSum, t2Sum, tSumLo, t2SumLo;
+    std::vector<double> x[N], xSum[N], x2Sum[N], xtSum[N], xSumLo[N], x2SumLo[N], xtSumLo[N];
+};
+
+/**
+ * @brief The LssdKernelT class evaluates LSSD (Local integral Square Synchronous Euclidean Distance) of segments in N
+ * spatial dimensions.
+ *
+ * LSSD is evaluated in the frame of the first point of the segment, i.e. the sums of squares and products of the inner
+ * points are shifted to the first point before they are combined. The expanded formula is then only as large as the
+ * extent of the segment. The sums of the inner points are the differences of compensated prefix sums, taken part by
+ * part, so they are accurate however many points precede the segment; the shift itself still cancels terms as large
+ * as the squared distance of the segment to the origin of the prefix sums (see PrefixStatisticsT).
+ *
+ * Square SED is separable over the axes, so LSSD is the sum of one term per axis. The loops over the axes have the
+ * compile-time trip count N and are unrolled by the compiler, so the 2D kernel is the same code as a hand-written one.
+ *
+ * The batched version evaluates one last point against a range of frontier candidates. It uses AVX-512 or AVX when
+ * the compiler targets them (see CONFIG+=dots_avx2 / CONFIG+=dots_avx512 in dots.pro) and falls back to the scalar
+ * version otherwise. All versions share the same order of floating point operations.
+ *
+ * Rounding of the expanded formula may leave a slightly negative result for segments whose inner points are (nearly)
+ * on the line. It is clamped to 0, so that LSSD is never negative and ISSED never decreases along a path, which the
+ * pruning of DotsCoreT::minimizeISSED() relies on.
+ */
+template<int N>
+class LssdKernelT {
+public:
+    /**
+     * @brief lssd calculates the LSSD of the segment from f to l.
+     * @param f is the first point of the segment.
+     * @param l is the last point of the segment.
+     * @return the LSSD distance.
+     */
+    static inline double lssd(const LssdPointT<N> &f, const LssdPointT<N> &l)
+    {
+        double n = l.index-f.index;
+        if (n <= 0)
+            return 0;
+
+        double inv = 1.0/(l.t-f.t);
+        double dT = (l.tSum-f.tSum)+(l.tSumLo-f.tSumLo);
+        double stt = ((l.t2Sum-f.t2Sum)+(l.t2SumLo-f.t2SumLo)) - 2*f.t*dT + n*f.t*f.t;
+        double value = 0;
+        for (int a=0; a<N; ++a)
+        {
+            double term = axis(n, inv, dT, stt, f.t, f.x[a], l.x[a], (l.xSum[a]-f.xSum[a])+(l.xSumLo[a]-f.xSumLo[a]),
+                               (l.x2Sum[a]-f.x2Sum[a])+(l.x2SumLo[a]-f.x2SumLo[a]),
+                               (l.xtSum[a]-f.xtSum[a])+(l.xtSumLo[a]-f.xtSumLo[a]));
+            value = (a == 0) ? term : value+term;
+        }
+        return (0 > value) ? 0 : value;
+    }
+
+    /**
+     * @brief evaluate calculates LSSD from each frontier candidate in range [begin, end) to l.
+     * @param frontier contains the first points of the segments.
+     * @param begin is the first candidate to evaluate.
+     * @param end is one past the last candidate to evaluate.
+     * @param l is the last point of the segments.
+     * @param out receives the LSSD of the k-th candidate at out[k].
+     */
+    static inline void evaluate(const LssdFrontierT<N> &frontier, int begin, int end, const LssdPointT<N> &l,
+                                double *out)
+    {
+        int k = begin;
+#if defined(__AVX512F__)
+        k = evaluateAvx512(frontier, k, end, l, out);
+#endif
+#if defined(__AVX__)
+        k = evaluateAvx(frontier, k, end, l, out);
+#endif
+        for (; k<end; ++k)
+            out[k] = lssd(frontier.get(k), l);
+    }
+
+protected:
+    /**
+     * @brief axis calculates the square SED summed over the inner points of a segment along one axis.
+     * @param n is the number of inner points.
+     * @param inv is the reciprocal of the segment duration.
+     * @param dT is the sum of inner timestamps.
+     * @param stt is the sum of squared inner timestamps relative to the first point.
+     * @param ft is the timestamp of the first point.
+     * @param fx is the position of the first point.
+     * @param lx is the position of the last point.
+     * @param dX is the sum of inner positions.
+     * @param dX2 is the sum of squared inner positions.
+     * @param dXT is the sum of inner position-timestamp products.
+     * @return the square SED along the axis.
+     */
+    static inline double axis(double n, double inv, double dT, double stt, double ft, double fx, double lx,
+                              double dX, double dX2, double dXT)
+    {
+        double sxx = dX2 - 2*fx*dX + n*fx*fx;
+        double sxt = dXT - ft*dX - fx*dT + n*fx*ft;
+        double k = (lx-fx)*inv;
+        return sxx - 2*k*sxt + k*k*stt;
+    }
+
+#if defined(__AVX__)
+    static inline __m256d axisAvx(__m256d n, __m256d inv, __m256d dT, __m256d stt, __m256d ft, __m256d fx,
+                                  __m256d lx, __m256d dX, __m256d dX2, __m256d dXT)
+    {
+        const __m256d two = _mm256_set1_pd(2.0);
+        __m256d sxx = _mm256_add_pd(_mm256_sub_pd(dX2, _mm256_mul_pd(_mm256_mul_pd(two, fx), dX)),
+                                    _mm256_mul_pd(_mm256_mul_pd(n, fx), fx));
+        __m256d sxt = _mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(dXT, _mm256_mul_pd(ft, dX)), _mm256_mul_pd(fx, dT)),
+                                    _mm256_mul_pd(_mm256_mul_pd(n, fx), ft));
+        __m256d k = _mm256_mul_pd(_mm256_sub_pd(lx, fx), inv);
+        return _mm256_add_pd(_mm256_sub_pd(sxx, _mm256_mul_pd(_mm256_mul_pd(two, k), sxt)),
+                             _mm256_mul_pd(_mm256_mul_pd(k, k), stt));
+    }
+
+    static inline __m256d diffAvx(__m256d hi, const double *fHi, __m256d lo, const double *fLo)
+    {
+        return _mm256_add_pd(_mm256_sub_pd(hi, _mm256_loadu_pd(fHi)), _mm256_sub_pd(lo, _mm256_loadu_pd(fLo)));
+    }
+
+    static inline int evaluateAvx(const LssdFrontierT<N> &f, int k, int end, const LssdPointT<N> &l, double *out)
+    {
+        const double *fIndex = f.index.data(), *ft = f.t.data(), *fTSum = f.tSum.data(), *fT2Sum = f.t2Sum.data();
+        const double *fTSumLo = f.tSumLo.data(), *fT2SumLo = f.t2SumLo.data();
+        const double *fx[N], *fXSum[N], *fX2Sum[N], *fXTSum[N], *fXSumLo[N], *fX2SumLo[N], *fXTSumLo[N];
+        __m256d lx[N], lXSum[N], lX2Sum[N], lXTSum[N], lXSumLo[N], lX2SumLo[N], lXTSumLo[N];
+        for (int a=0; a<N; ++a)
+        {
+            fx[a] = f.x[a].data();
+            fXSum[a] = f.xSum[a].data();
+            fX2Sum[a] = f.x2Sum[a].data();
+            fXTSum[a] = f.xtSum[a].data();
+            fXSumLo[a] = f.xSumLo[a].data();
+            fX2SumLo[a] = f.x2SumLo[a].data();
+            fXTSumLo[a] = f.xtSumLo[a].data();
+            lx[a] = _mm256_set1_pd(l.x[a]);
+            lXSum[a] = _mm256_set1_pd(l.xSum[a]);
+            lX2Sum[a] = _mm256_set1_pd(l.x2Sum[a]);
+            lXTSum[a] = _mm256_set1_pd(l.xtSum[a]);
+            lXSumLo[a] = _mm256_set1_pd(l.xSumLo[a]);
+            lX2SumLo[a] = _mm256_set1_pd(l.x2SumLo[a]);
+            lXTSumLo[a] = _mm256_set1_pd(l.xtSumLo[a]);
+        }
+        const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0), two = _mm256_set1_pd(2.0);
+        const __m256d lIndex = _mm256_set1_pd(l.index), lt = _mm256_set1_pd(l.t);
+        const __m256d lTSum = _mm256_set1_pd(l.tSum), lT2Sum = _mm256_set1_pd(l.t2Sum);
+        const __m256d lTSumLo = _mm256_set1_pd(l.tSumLo), lT2SumLo = _mm256_set1_pd(l.t2SumLo);
+        for (; k+4<=end; k+=4)
+        {
+            __m256d n = _mm256_sub_pd(lIndex, _mm256_loadu_pd(fIndex+k));
+            __m256d t = _mm256_loadu_pd(ft+k);
+            __m256d inv = _mm256_div_pd(one, _mm256_sub_pd(lt, t));
+            __m256d dT = diffAvx(lTSum, fTSum+k, lTSumLo, fTSumLo+k);
+            __m256d stt = _mm256_add_pd(_mm256_sub_pd(diffAvx(lT2Sum, fT2Sum+k, lT2SumLo, fT2SumLo+k),
+                                                      _mm256_mul_pd(_mm256_mul_pd(two, t), dT)),
+                                        _mm256_mul_pd(_mm256_mul_pd(n, t), t));
+            __m256d value = zero;
+            for (int a=0; a<N; ++a)
+            {
+                __m256d term = axisAvx(n, inv, dT, stt, t, _mm256_loadu_pd(fx[a]+k), lx[a],
+                                       diffAvx(lXSum[a], fXSum[a]+k, lXSumLo[a], fXSumLo[a]+k),
+                                       diffAvx(lX2Sum[a], fX2Sum[a]+k, lX2SumLo[a], fX2SumLo[a]+k),
+                                       diffAvx(lXTSum[a], fXTSum[a]+k, lXTSumLo[a], fXTSumLo[a]+k));
+                value = (a == 0) ? term : _mm256_add_pd(value, term);
+            }
+
+            // Segments without inner points have zero LSSD.
+            __m256d mask = _mm256_cmp_pd(n, zero, _CMP_GT_OQ);
+            _mm256_storeu_pd(out+k, _mm256_and_pd(mask, _mm256_max_pd(zero, value)));
+        }
+        return k;
+    }
+#endif
+
+#if defined(__AVX512F__)
+    static inline __m512d axisAvx512(__m512d n, __m512d inv, __m512d dT, __m512d stt, __m512d ft, __m512d fx,
+                                     __m512d lx, __m512d dX, __m512d dX2, __m512d dXT)
+    {
+        const __m512d two = _mm512_set1_pd(2.0);
+        __m512d sxx = _mm512_add_pd(_mm512_sub_pd(dX2, _mm512_mul_pd(_mm512_mul_pd(two, fx), dX)),
+                                    _mm512_mul_pd(_mm512_mul_pd(n, fx), fx));
+        __m512d sxt = _mm512_add_pd(_mm512_sub_pd(_mm512_sub_pd(dXT, _mm512_mul_pd(ft, dX)), _mm512_mul_pd(fx, dT)),
+                                    _mm512_mul_pd(_mm512_mul_pd(n, fx), ft));
+        __m512d k = _mm512_mul_pd(_mm512_sub_pd(lx, fx), inv);
+        return _mm512_add_pd(_mm512_sub_pd(sxx, _mm512_mul_pd(_mm512_mul_pd(two, k), sxt)),
+                             _mm512_mul_pd(_mm512_mul_pd(k, k), stt));
+    }
+
+    static inline __m512d diffAvx512(__m512d hi, const double *fHi, __m512d lo, const double *fLo)
+    {
+        return _mm512_add_pd(_mm512_sub_pd(hi, _mm512_loadu_pd(fHi)), _mm512_sub_pd(lo, _mm512_loadu_pd(fLo)));
+    }
+
+    static inline int evaluateAvx512(const LssdFrontierT<N> &f, int k, int end, const LssdPointT<N> &l, double *out)
+    {
+        const double *fIndex = f.index.data(), *ft = f.t.data(), *fTSum = f.tSum.data(), *fT2Sum = f.t2Sum.data();
+        const double *fTSumLo = f.tSumLo.data(), *fT2SumLo = f.t2SumLo.data();
+        const double *fx[N], *fXSum[N], *fX2Sum[N], *fXTSum[N], *fXSumLo[N], *fX2SumLo[N], *fXTSumLo[N];
+        __m512d lx[N], lXSum[N], lX2Sum[N], lXTSum[N], lXSumLo[N], lX2SumLo[N], lXTSumLo[N];
+        for (int a=0; a<N; ++a)
+        {
+            fx[a] = f.x[a].data();
+            fXSum[a] = f.xSum[a].data();
+            fX2Sum[a] = f.x2Sum[a].data();
+            fXTSum[a] = f.xtSum[a].data();
+            fXSumLo[a] = f.xSumLo[a].data();
+            fX2SumLo[a] = f.x2SumLo[a].data();
+            fXTSumLo[a] = f.xtSumLo[a].data();
+            lx[a] = _mm512_set1_pd(l.x[a]);
+            lXSum[a] = _mm512_set1_pd(l.xSum[a]);
+            lX2Sum[a] = _mm512_set1_pd(l.x2Sum[a]);
+            lXTSum[a] = _mm512_set1_pd(l.xtSum[a]);
+            lXSumLo[a] = _mm512_set1_pd(l.xSumLo[a]);
+            lX2SumLo[a] = _mm512_set1_pd(l.x2SumLo[a]);
+            lXTSumLo[a] = _mm512_set1_pd(l.xtSumLo[a]);
+        }
+        const __m512d zero = _mm512_setzero_pd(), one = _mm512_set1_pd(1.0), two = _mm512_set1_pd(2.0);
+        const __m512d lIndex = _mm512_set1_pd(l.index), lt = _mm512_set1_pd(l.t);
+        const __m512d lTSum = _mm512_set1_pd(l.tSum), lT2Sum = _mm512_set1_pd(l.t2Sum);
+        const __m512d lTSumLo = _mm512_set1_pd(l.tSumLo), lT2SumLo = _mm512_set1_pd(l.t2SumLo);
+        for (; k+8<=end; k+=8)
+        {
+            __m512d n = _mm512_sub_pd(lIndex, _mm512_loadu_pd(fIndex+k));
+            __m512d t = _mm512_loadu_pd(ft+k);
+            __m512d inv = _mm512_div_pd(one, _mm512_sub_pd(lt, t));
+            __m512d dT = diffAvx512(lTSum, fTSum+k, lTSumLo, fTSumLo+k);
+            __m512d stt = _mm512_add_pd(_mm512_sub_pd(diffAvx512(lT2Sum, fT2Sum+k, lT2SumLo, fT2SumLo+k),
+                                                      _mm512_mul_pd(_mm512_mul_pd(two, t), dT)),
+                                        _mm512_mul_pd(_mm512_mul_pd(n, t), t));
+            __m512d value = zero;
+            for (int a=0; a<N; ++a)
+            {
+                __m512d term = axisAvx512(n, inv, dT, stt, t, _mm512_loadu_pd(fx[a]+k), lx[a],
+                                          diffAvx512(lXSum[a], fXSum[a]+k, lXSumLo[a], fXSumLo[a]+k),
+                                          diffAvx512(lX2Sum[a], fX2Sum[a]+k, lX2SumLo[a], fX2SumLo[a]+k),
+                                          diffAvx512(lXTSum[a], fXTSum[a]+k, lXTSumLo[a], fXTSumLo[a]+k));
+                value = (a == 0) ? term : _mm512_add_pd(value, term);
+            }
+
+            // Segments without inner points have zero LSSD.
+            __mmask8 mask = _mm512_cmp_pd_mask(n, zero, _CMP_GT_OQ);
+            _mm512_storeu_pd(out+k, _mm512_maskz_mov_pd(mask, _mm512_max_pd(zero, value)));
+        }
+        return k;
+    }
+#endif
+};
+
+/**
+ * @brief LssdPoint, LssdFrontier and LssdKernel are the 2D instantiations.
+ */
+typedef LssdPointT<2> LssdPoint;
+typedef LssdFrontierT<2> LssdFrontier;
+typedef LssdKernelT<2> LssdKernel;
+
+#endif // LSSDKERNEL_H
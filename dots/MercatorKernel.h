@@ -0,0 +1,624 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief MercatorKernel.h defines the MercatorKernel class, the batched mercator projection used by Helper.
+  * @author caoweiquan322
+  */
+#ifndef MERCATORKERNEL_H
+#define MERCATORKERNEL_H
+
+#include<cmath>
+#include<cstdint>
+#include<cstring>
+#if defined(__AVX2__)
+#include<immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include<emmintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+/**
+ * @brief The MercatorKernel class projects columns of longitude/latitude pairs to mercator x/y values and back.
+ *
+ * The projection is y = R/sf*ln(tan(lat)+sec(lat)), which is evaluated as R/sf*atanh(sin(lat)), and its inverse is
+ * lat = 2*atan(tanh(y*sf/(2R))). sin, ln, exp and atan are evaluated by polynomials after range reduction, so that
+ * whole columns run through the same straight-line code. It uses AVX2 when the compiler targets it (see
+ * CONFIG+=dots_avx2 / CONFIG+=dots_avx512 in dots.pro), SSE2 on other x86-64 targets, and falls back to the scalar
+ * version otherwise. All versions share the same order of floating point operations, so they give the same results,
+ * except in the last place where the compiler contracts operations into FMA instructions, e.g. for AVX-512.
+ *
+ * Latitudes are limited to [-85, 85] degrees, beyond which the projection diverges. The polynomials are accurate to
+ * a few units in the last place: for sf >= 1, projected y values are within 2e-7 m of the exact projection, which
+ * is less than the 4e-7 m of ln(tan(lat)+sec(lat)) by the C library (the error grows towards the latitude limits,
+ * as 1-sin(lat) cancels). x values are exactly those of longitude*(pi/180)*R/sf, and the inverse is within 1e-13
+ * degrees, i.e. about 1e-8 m, of the exact inverse.
+ *
+ * The class is header-only and depends on the standard library only.
+ */
+class MercatorKernel
+{
+public:
+    /**
+     * @brief project does mercator projection on n longitude/latitude pairs. The outputs may be the inputs, i.e.
+     * a column may be projected in place.
+     * @param longitude is the longitude of positions in degrees.
+     * @param latitude is the latitude of positions in degrees.
+     * @param n is the number of positions.
+     * @param scaleFactor is the scale factor of the projection.
+     * @param x receives the x values of positions. It must hold n values.
+     * @param y receives the y values of positions. It must hold n values.
+     */
+    static inline void project(const double *longitude, const double *latitude, int n, double scaleFactor,
+                               double *x, double *y)
+    {
+        int k = 0;
+#if defined(__AVX2__)
+        k = projectAvx2(longitude, latitude, n, scaleFactor, x, y);
+#elif defined(__SSE2__) || defined(_M_X64)
+        k = projectSse2(longitude, latitude, n, scaleFactor, x, y);
+#endif
+        for (; k<n; ++k)
+            projectPoint(longitude[k], latitude[k], scaleFactor, x[k], y[k]);
+    }
+
+    /**
+     * @brief unproject is the inverse of project(). The outputs may be the inputs.
+     * @param x is the x values of positions.
+     * @param y is the y values of positions.
+     * @param n is the number of positions.
+     * @param scaleFactor is the scale factor of the projection.
+     * @param longitude receives the longitude of positions in degrees. It must hold n values.
+     * @param latitude receives the latitude of positions in degrees. It must hold n values.
+     */
+    static inline void unproject(const double *x, const double *y, int n, double scaleFactor, double *longitude,
+                                 double *latitude)
+    {
+        int k = 0;
+#if defined(__AVX2__)
+        k = unprojectAvx2(x, y, n, scaleFactor, longitude, latitude);
+#elif defined(__SSE2__) || defined(_M_X64)
+        k = unprojectSse2(x, y, n, scaleFactor, longitude, latitude);
+#endif
+        for (; k<n; ++k)
+            unprojectPoint(x[k], y[k], scaleFactor, longitude[k], latitude[k]);
+    }
+
+    /**
+     * @brief projectPoint is project() for one position.
+     */
+    static inline void projectPoint(double longitude, double latitude, double scaleFactor, double &x, double &y)
+    {
+        // Limit the latitude like fmax/fmin, but keeping NaN.
+        double limited = (latitude > LATITUDE_LB) ? latitude : LATITUDE_LB;
+        limited = (limited < LATITUDE_UB) ? limited : LATITUDE_UB;
+        limited = (latitude != latitude) ? latitude : limited;
+
+        // Evaluate atanh(sin(lat)) for |lat| and restore the sign, as both are odd.
+        double phi = limited*DEG_TO_RAD;
+        double a = std::fabs(phi);
+        double s = sinPolynomial(a);
+        double q = (1.0+s)/(1.0-s);
+        double e, m;
+        splitExponent(q, e, m);
+        double r = 0.5*logPolynomial(e, m);
+        r = std::copysign(r, phi);
+        r = (phi != phi) ? phi : r;
+
+        x = longitude*DEG_TO_RAD*EARTH_RADIUS/scaleFactor;
+        y = r*EARTH_RADIUS/scaleFactor;
+    }
+
+    /**
+     * @brief unprojectPoint is unproject() for one position.
+     */
+    static inline void unprojectPoint(double x, double y, double scaleFactor, double &longitude, double &latitude)
+    {
+        // Evaluate 2*atan(tanh(|y|/2)) and restore the sign. tanh saturates long before |y| reaches the limit.
+        double v = y*scaleFactor/EARTH_RADIUS;
+        double a = std::fabs(v);
+        a = (a < EXP_ARGUMENT_LIMIT || a != a) ? a : EXP_ARGUMENT_LIMIT;
+        double n = std::nearbyint(a*LOG2_E);
+        double ex = expPolynomial(a-n*LN2_HI-n*LN2_LO)*powerOfTwo(n);
+        double u = (ex-1.0)/(ex+1.0);
+        double kIndex = std::nearbyint(u*ATAN_STEPS);
+        double c = kIndex/ATAN_STEPS;
+        double w = (u-c)/(1.0+u*c);
+        int index = (kIndex == kIndex) ? static_cast<int>(kIndex) : 0;
+        double phi = 2.0*(atanTable()[index]+atanPolynomial(w));
+        phi = std::copysign(phi, v);
+        phi = (v != v) ? v : phi;
+
+        longitude = x*scaleFactor/EARTH_RADIUS*RAD_TO_DEG;
+        latitude = phi*RAD_TO_DEG;
+    }
+
+    /**
+     * @brief EARTH_RADIUS is the radius of the earth in meters.
+     */
+    static constexpr double EARTH_RADIUS = 6378100.0;
+
+protected:
+    /**
+     * @brief sinPolynomial evaluates sin(a) for a in [0, pi/2] by its Taylor series up to a^21, whose remainder is
+     * below 1e-18.
+     */
+    static inline double sinPolynomial(double a)
+    {
+        const double *c = sinCoefficients();
+        double a2 = a*a;
+        double p = c[0];
+        for (int k=1; k<SIN_TERMS; ++k)
+            p = p*a2+c[k];
+        return a+a*a2*p;
+    }
+
+    /**
+     * @brief splitExponent splits a positive finite q into 2^e*m with m in [sqrt(1/2), sqrt(2)).
+     */
+    static inline void splitExponent(double q, double &e, double &m)
+    {
+        uint64_t bits;
+        memcpy(&bits, &q, sizeof(bits));
+        uint64_t mantissaBits = (bits & MANTISSA_MASK) | ONE_BITS;
+        memcpy(&m, &mantissaBits, sizeof(m));
+        e = static_cast<double>(static_cast<int>(bits >> 52))-1023.0;
+        if (m > SQRT_2)
+        {
+            m = m*0.5;
+            e = e+1.0;
+        }
+    }
+
+    /**
+     * @brief logPolynomial evaluates ln(2^e*m) as e*ln(2)+2*atanh((m-1)/(m+1)), where the series of atanh runs up to
+     * the 23rd power of |(m-1)/(m+1)| <= 0.172, whose remainder is below 1e-19.
+     */
+    static inline double logPolynomial(double e, double m)
+    {
+        const double *c = logCoefficients();
+        double f = (m-1.0)/(m+1.0);
+        double f2 = f*f;
+        double p = c[0];
+        for (int k=1; k<LOG_TERMS; ++k)
+            p = p*f2+c[k];
+        return e*LN2_HI+(e*LN2_LO+(2.0*f+2.0*f*f2*p));
+    }
+
+    /**
+     * @brief expPolynomial evaluates exp(r) for |r| <= ln(2)/2 by its Taylor series up to r^13, whose remainder is
+     * below 1e-17.
+     */
+    static inline double expPolynomial(double r)
+    {
+        const double *c = expCoefficients();
+        double p = c[0];
+        for (int k=1; k<EXP_TERMS; ++k)
+            p = p*r+c[k];
+        return p;
+    }
+
+    /**
+     * @brief powerOfTwo builds 2^n for an integral n in [0, 1023].
+     */
+    static inline double powerOfTwo(double n)
+    {
+        uint64_t bits = static_cast<uint64_t>(static_cast<int>(n)+1023) << 52;
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief atanPolynomial evaluates atan(w) for |w| <= 1/(2*ATAN_STEPS) by its series up to w^19, whose remainder
+     * is below 1e-20.
+     */
+    static inline double atanPolynomial(double w)
+    {
+        const double *c = atanCoefficients();
+        double w2 = w*w;
+        double p = c[0];
+        for (int k=1; k<ATAN_TERMS; ++k)
+            p = p*w2+c[k];
+        return w+w*w2*p;
+    }
+
+    /**
+     * @brief sinCoefficients retrieves (-1)^k/(2k+1)! for k from 10 down to 1.
+     */
+    static inline const double *sinCoefficients()
+    {
+        static const double COEFFICIENTS[] = {1.9572941063391263e-20, -8.22063524662433e-18, 2.8114572543455206e-15,
+                                              -7.647163731819816e-13, 1.6059043836821613e-10, -2.505210838544172e-08,
+                                              2.7557319223985893e-06, -0.0001984126984126984, 0.008333333333333333,
+                                              -0.16666666666666666};
+        return COEFFICIENTS;
+    }
+
+    /**
+     * @brief logCoefficients retrieves 1/(2k+1) for k from 11 down to 1.
+     */
+    static inline const double *logCoefficients()
+    {
+        static const double COEFFICIENTS[] = {1.0/23, 1.0/21, 1.0/19, 1.0/17, 1.0/15, 1.0/13, 1.0/11, 1.0/9, 1.0/7,
+                                              1.0/5, 1.0/3};
+        return COEFFICIENTS;
+    }
+
+    /**
+     * @brief expCoefficients retrieves 1/k! for k from 13 down to 0.
+     */
+    static inline const double *expCoefficients()
+    {
+        static const double COEFFICIENTS[] = {1.6059043836821613e-10, 2.08767569878681e-09, 2.505210838544172e-08,
+                                              2.755731922398589e-07, 2.7557319223985893e-06, 2.48015873015873e-05,
+                                              0.0001984126984126984, 0.001388888888888889, 0.008333333333333333,
+                                              0.041666666666666664, 0.16666666666666666, 0.5, 1.0, 1.0};
+        return COEFFICIENTS;
+    }
+
+    /**
+     * @brief atanCoefficients retrieves (-1)^k/(2k+1) for k from 9 down to 1.
+     */
+    static inline const double *atanCoefficients()
+    {
+        static const double COEFFICIENTS[] = {-1.0/19, 1.0/17, -1.0/15, 1.0/13, -1.0/11, 1.0/9, -1.0/7, 1.0/5,
+                                              -1.0/3};
+        return COEFFICIENTS;
+    }
+
+    /**
+     * @brief atanTable retrieves atan(k/ATAN_STEPS) for k in [0, ATAN_STEPS], the centres atan is reduced to.
+     */
+    static inline const double *atanTable()
+    {
+        static const double TABLE[] = {0.0, 0.24497866312686414, 0.4636476090008061, 0.6435011087932844,
+                                       0.7853981633974483};
+        return TABLE;
+    }
+
+#if defined(__AVX2__)
+    /**
+     * @brief projectAvx2 is project() for the leading multiple of 4 positions.
+     * @return the number of positions projected.
+     */
+    static inline int projectAvx2(const double *longitude, const double *latitude, int n, double scaleFactor,
+                                  double *x, double *y)
+    {
+        const __m256d degToRad = _mm256_set1_pd(DEG_TO_RAD);
+        const __m256d radius = _mm256_set1_pd(EARTH_RADIUS);
+        const __m256d sf = _mm256_set1_pd(scaleFactor);
+        const __m256d lb = _mm256_set1_pd(LATITUDE_LB);
+        const __m256d ub = _mm256_set1_pd(LATITUDE_UB);
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d half = _mm256_set1_pd(0.5);
+        const __m256d two = _mm256_set1_pd(2.0);
+        const __m256d signMask = _mm256_set1_pd(-0.0);
+        const __m256i mantissaMask = _mm256_set1_epi64x(static_cast<long long>(MANTISSA_MASK));
+        const __m256i oneBits = _mm256_set1_epi64x(static_cast<long long>(ONE_BITS));
+        const __m256d twoTo52 = _mm256_set1_pd(4503599627370496.0);
+        const __m256d bias = _mm256_set1_pd(1023.0);
+        const __m256d sqrt2 = _mm256_set1_pd(SQRT_2);
+        const __m256d ln2Hi = _mm256_set1_pd(LN2_HI);
+        const __m256d ln2Lo = _mm256_set1_pd(LN2_LO);
+        const double *sinC = sinCoefficients();
+        const double *logC = logCoefficients();
+
+        int k = 0;
+        for (; k+4<=n; k+=4)
+        {
+            __m256d latitudeV = _mm256_loadu_pd(latitude+k);
+            __m256d longitudeV = _mm256_loadu_pd(longitude+k);
+
+            // max/min return their second operand if either is NaN, which keeps a NaN latitude.
+            __m256d phi = _mm256_mul_pd(_mm256_min_pd(ub, _mm256_max_pd(lb, latitudeV)), degToRad);
+            __m256d a = _mm256_andnot_pd(signMask, phi);
+
+            // sin(a).
+            __m256d a2 = _mm256_mul_pd(a, a);
+            __m256d p = _mm256_set1_pd(sinC[0]);
+            for (int c=1; c<SIN_TERMS; ++c)
+                p = _mm256_add_pd(_mm256_mul_pd(p, a2), _mm256_set1_pd(sinC[c]));
+            __m256d s = _mm256_add_pd(a, _mm256_mul_pd(_mm256_mul_pd(a, a2), p));
+            __m256d q = _mm256_div_pd(_mm256_add_pd(one, s), _mm256_sub_pd(one, s));
+
+            // Split q into 2^e*m. The biased exponent is converted through the mantissa of 2^52.
+            __m256i bits = _mm256_castpd_si256(q);
+            __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, mantissaMask), oneBits));
+            __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52),
+                                                                          _mm256_castpd_si256(twoTo52))), twoTo52);
+            e = _mm256_sub_pd(e, bias);
+            __m256d above = _mm256_cmp_pd(m, sqrt2, _CMP_GT_OQ);
+            m = _mm256_blendv_pd(m, _mm256_mul_pd(m, half), above);
+            e = _mm256_add_pd(e, _mm256_and_pd(above, one));
+
+            // ln(q).
+            __m256d f = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+            __m256d f2 = _mm256_mul_pd(f, f);
+            p = _mm256_set1_pd(logC[0]);
+            for (int c=1; c<LOG_TERMS; ++c)
+                p = _mm256_add_pd(_mm256_mul_pd(p, f2), _mm256_set1_pd(logC[c]));
+            __m256d lnM = _mm256_add_pd(_mm256_mul_pd(two, f), _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(two, f), f2),
+                                                                             p));
+            __m256d r = _mm256_add_pd(_mm256_mul_pd(e, ln2Hi), _mm256_add_pd(_mm256_mul_pd(e, ln2Lo), lnM));
+            r = _mm256_mul_pd(half, r);
+
+            // Restore the sign and NaN.
+            r = _mm256_or_pd(r, _mm256_and_pd(phi, signMask));
+            r = _mm256_blendv_pd(r, phi, _mm256_cmp_pd(phi, phi, _CMP_UNORD_Q));
+
+            _mm256_storeu_pd(x+k, _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(longitudeV, degToRad), radius), sf));
+            _mm256_storeu_pd(y+k, _mm256_div_pd(_mm256_mul_pd(r, radius), sf));
+        }
+        return k;
+    }
+
+    /**
+     * @brief unprojectAvx2 is unproject() for the leading multiple of 4 positions.
+     * @return the number of positions unprojected.
+     */
+    static inline int unprojectAvx2(const double *x, const double *y, int n, double scaleFactor, double *longitude,
+                                    double *latitude)
+    {
+        const __m256d radToDeg = _mm256_set1_pd(RAD_TO_DEG);
+        const __m256d radius = _mm256_set1_pd(EARTH_RADIUS);
+        const __m256d sf = _mm256_set1_pd(scaleFactor);
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d two = _mm256_set1_pd(2.0);
+        const __m256d signMask = _mm256_set1_pd(-0.0);
+        const __m256d limit = _mm256_set1_pd(EXP_ARGUMENT_LIMIT);
+        const __m256d log2E = _mm256_set1_pd(LOG2_E);
+        const __m256d ln2Hi = _mm256_set1_pd(LN2_HI);
+        const __m256d ln2Lo = _mm256_set1_pd(LN2_LO);
+        const __m256d steps = _mm256_set1_pd(ATAN_STEPS);
+        const __m256i bias = _mm256_set1_epi64x(1023);
+        const double *expC = expCoefficients();
+        const double *atanC = atanCoefficients();
+        const double *table = atanTable();
+
+        int k = 0;
+        for (; k+4<=n; k+=4)
+        {
+            __m256d xV = _mm256_loadu_pd(x+k);
+            __m256d v = _mm256_div_pd(_mm256_mul_pd(_mm256_loadu_pd(y+k), sf), radius);
+
+            // min returns its second operand if either is NaN, which keeps a NaN argument.
+            __m256d a = _mm256_min_pd(limit, _mm256_andnot_pd(signMask, v));
+
+            // exp(a) = 2^n*exp(a-n*ln(2)).
+            __m256d nV = _mm256_round_pd(_mm256_mul_pd(a, log2E), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            __m256d r = _mm256_sub_pd(_mm256_sub_pd(a, _mm256_mul_pd(nV, ln2Hi)), _mm256_mul_pd(nV, ln2Lo));
+            __m256d p = _mm256_set1_pd(expC[0]);
+            for (int c=1; c<EXP_TERMS; ++c)
+                p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(expC[c]));
+            __m256i exponent = _mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(nV)), bias),
+                                                 52);
+            __m256d ex = _mm256_mul_pd(p, _mm256_castsi256_pd(exponent));
+
+            // atan(tanh(a/2)), reduced to the nearest tabulated centre.
+            __m256d u = _mm256_div_pd(_mm256_sub_pd(ex, one), _mm256_add_pd(ex, one));
+            __m256d kIndex = _mm256_round_pd(_mm256_mul_pd(u, steps), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            __m256d c = _mm256_div_pd(kIndex, steps);
+            __m256d w = _mm256_div_pd(_mm256_sub_pd(u, c), _mm256_add_pd(one, _mm256_mul_pd(u, c)));
+            __m256d w2 = _mm256_mul_pd(w, w);
+            p = _mm256_set1_pd(atanC[0]);
+            for (int j=1; j<ATAN_TERMS; ++j)
+                p = _mm256_add_pd(_mm256_mul_pd(p, w2), _mm256_set1_pd(atanC[j]));
+            __m256d atanW = _mm256_add_pd(w, _mm256_mul_pd(_mm256_mul_pd(w, w2), p));
+
+            // NaN lanes index the table with garbage, so they are cleared to 0 first and restored below.
+            __m256d nan = _mm256_cmp_pd(v, v, _CMP_UNORD_Q);
+            __m128i index = _mm256_cvtpd_epi32(_mm256_andnot_pd(nan, kIndex));
+            __m256d centre = _mm256_i32gather_pd(table, index, 8);
+            __m256d phi = _mm256_mul_pd(two, _mm256_add_pd(centre, atanW));
+            phi = _mm256_or_pd(phi, _mm256_and_pd(v, signMask));
+            phi = _mm256_blendv_pd(phi, v, nan);
+
+            _mm256_storeu_pd(longitude+k, _mm256_mul_pd(_mm256_div_pd(_mm256_mul_pd(xV, sf), radius), radToDeg));
+            _mm256_storeu_pd(latitude+k, _mm256_mul_pd(phi, radToDeg));
+        }
+        return k;
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    /**
+     * @brief projectSse2 is project() for the leading multiple of 2 positions.
+     * @return the number of positions projected.
+     */
+    static inline int projectSse2(const double *longitude, const double *latitude, int n, double scaleFactor,
+                                  double *x, double *y)
+    {
+        const __m128d degToRad = _mm_set1_pd(DEG_TO_RAD);
+        const __m128d radius = _mm_set1_pd(EARTH_RADIUS);
+        const __m128d sf = _mm_set1_pd(scaleFactor);
+        const __m128d lb = _mm_set1_pd(LATITUDE_LB);
+        const __m128d ub = _mm_set1_pd(LATITUDE_UB);
+        const __m128d one = _mm_set1_pd(1.0);
+        const __m128d half = _mm_set1_pd(0.5);
+        const __m128d two = _mm_set1_pd(2.0);
+        const __m128d signMask = _mm_set1_pd(-0.0);
+        const __m128i mantissaMask = _mm_set1_epi64x(static_cast<long long>(MANTISSA_MASK));
+        const __m128i oneBits = _mm_set1_epi64x(static_cast<long long>(ONE_BITS));
+        const __m128d twoTo52 = _mm_set1_pd(4503599627370496.0);
+        const __m128d bias = _mm_set1_pd(1023.0);
+        const __m128d sqrt2 = _mm_set1_pd(SQRT_2);
+        const __m128d ln2Hi = _mm_set1_pd(LN2_HI);
+        const __m128d ln2Lo = _mm_set1_pd(LN2_LO);
+        const double *sinC = sinCoefficients();
+        const double *logC = logCoefficients();
+
+        int k = 0;
+        for (; k+2<=n; k+=2)
+        {
+            __m128d latitudeV = _mm_loadu_pd(latitude+k);
+            __m128d longitudeV = _mm_loadu_pd(longitude+k);
+
+            // max/min return their second operand if either is NaN, which keeps a NaN latitude.
+            __m128d phi = _mm_mul_pd(_mm_min_pd(ub, _mm_max_pd(lb, latitudeV)), degToRad);
+            __m128d a = _mm_andnot_pd(signMask, phi);
+
+            // sin(a).
+            __m128d a2 = _mm_mul_pd(a, a);
+            __m128d p = _mm_set1_pd(sinC[0]);
+            for (int c=1; c<SIN_TERMS; ++c)
+                p = _mm_add_pd(_mm_mul_pd(p, a2), _mm_set1_pd(sinC[c]));
+            __m128d s = _mm_add_pd(a, _mm_mul_pd(_mm_mul_pd(a, a2), p));
+            __m128d q = _mm_div_pd(_mm_add_pd(one, s), _mm_sub_pd(one, s));
+
+            // Split q into 2^e*m. The biased exponent is converted through the mantissa of 2^52.
+            __m128i bits = _mm_castpd_si128(q);
+            __m128d m = _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, mantissaMask), oneBits));
+            __m128d e = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(bits, 52),
+                                                                 _mm_castpd_si128(twoTo52))), twoTo52);
+            e = _mm_sub_pd(e, bias);
+            __m128d above = _mm_cmpgt_pd(m, sqrt2);
+            m = _mm_or_pd(_mm_and_pd(above, _mm_mul_pd(m, half)), _mm_andnot_pd(above, m));
+            e = _mm_add_pd(e, _mm_and_pd(above, one));
+
+            // ln(q).
+            __m128d f = _mm_div_pd(_mm_sub_pd(m, one), _mm_add_pd(m, one));
+            __m128d f2 = _mm_mul_pd(f, f);
+            p = _mm_set1_pd(logC[0]);
+            for (int c=1; c<LOG_TERMS; ++c)
+                p = _mm_add_pd(_mm_mul_pd(p, f2), _mm_set1_pd(logC[c]));
+            __m128d lnM = _mm_add_pd(_mm_mul_pd(two, f), _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(two, f), f2), p));
+            __m128d r = _mm_add_pd(_mm_mul_pd(e, ln2Hi), _mm_add_pd(_mm_mul_pd(e, ln2Lo), lnM));
+            r = _mm_mul_pd(half, r);
+
+            // Restore the sign and NaN.
+            r = _mm_or_pd(r, _mm_and_pd(phi, signMask));
+            __m128d nan = _mm_cmpunord_pd(phi, phi);
+            r = _mm_or_pd(_mm_and_pd(nan, phi), _mm_andnot_pd(nan, r));
+
+            _mm_storeu_pd(x+k, _mm_div_pd(_mm_mul_pd(_mm_mul_pd(longitudeV, degToRad), radius), sf));
+            _mm_storeu_pd(y+k, _mm_div_pd(_mm_mul_pd(r, radius), sf));
+        }
+        return k;
+    }
+
+    /**
+     * @brief unprojectSse2 is unproject() for the leading multiple of 2 positions.
+     * @return the number of positions unprojected.
+     */
+    static inline int unprojectSse2(const double *x, const double *y, int n, double scaleFactor, double *longitude,
+                                    double *latitude)
+    {
+        const __m128d radToDeg = _mm_set1_pd(RAD_TO_DEG);
+        const __m128d radius = _mm_set1_pd(EARTH_RADIUS);
+        const __m128d sf = _mm_set1_pd(scaleFactor);
+        const __m128d one = _mm_set1_pd(1.0);
+        const __m128d two = _mm_set1_pd(2.0);
+        const __m128d signMask = _mm_set1_pd(-0.0);
+        const __m128d limit = _mm_set1_pd(EXP_ARGUMENT_LIMIT);
+        const __m128d log2E = _mm_set1_pd(LOG2_E);
+        const __m128d ln2Hi = _mm_set1_pd(LN2_HI);
+        const __m128d ln2Lo = _mm_set1_pd(LN2_LO);
+        const __m128d steps = _mm_set1_pd(ATAN_STEPS);
+        const __m128d twoTo52 = _mm_set1_pd(4503599627370496.0);
+        const __m128i bias = _mm_set1_epi64x(1023);
+        const double *expC = expCoefficients();
+        const double *atanC = atanCoefficients();
+        const double *table = atanTable();
+
+        int k = 0;
+        for (; k+2<=n; k+=2)
+        {
+            __m128d xV = _mm_loadu_pd(x+k);
+            __m128d v = _mm_div_pd(_mm_mul_pd(_mm_loadu_pd(y+k), sf), radius);
+
+            // min returns its second operand if either is NaN, which keeps a NaN argument.
+            __m128d a = _mm_min_pd(limit, _mm_andnot_pd(signMask, v));
+
+            // exp(a) = 2^n*exp(a-n*ln(2)). Adding and subtracting 2^52 rounds the non-negative n to the nearest
+            // integer, ties to even, like nearbyint().
+            __m128d nV = _mm_mul_pd(a, log2E);
+            nV = _mm_sub_pd(_mm_add_pd(nV, twoTo52), twoTo52);
+            __m128d r = _mm_sub_pd(_mm_sub_pd(a, _mm_mul_pd(nV, ln2Hi)), _mm_mul_pd(nV, ln2Lo));
+            __m128d p = _mm_set1_pd(expC[0]);
+            for (int c=1; c<EXP_TERMS; ++c)
+                p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(expC[c]));
+            __m128i exponent = _mm_slli_epi64(_mm_add_epi64(_mm_unpacklo_epi32(_mm_cvtpd_epi32(nV),
+                                                                               _mm_setzero_si128()), bias), 52);
+            __m128d ex = _mm_mul_pd(p, _mm_castsi128_pd(exponent));
+
+            // atan(tanh(a/2)), reduced to the nearest tabulated centre.
+            __m128d u = _mm_div_pd(_mm_sub_pd(ex, one), _mm_add_pd(ex, one));
+            __m128d kIndex = _mm_mul_pd(u, steps);
+            kIndex = _mm_sub_pd(_mm_add_pd(kIndex, twoTo52), twoTo52);
+            __m128d c = _mm_div_pd(kIndex, steps);
+            __m128d w = _mm_div_pd(_mm_sub_pd(u, c), _mm_add_pd(one, _mm_mul_pd(u, c)));
+            __m128d w2 = _mm_mul_pd(w, w);
+            p = _mm_set1_pd(atanC[0]);
+            for (int j=1; j<ATAN_TERMS; ++j)
+                p = _mm_add_pd(_mm_mul_pd(p, w2), _mm_set1_pd(atanC[j]));
+            __m128d atanW = _mm_add_pd(w, _mm_mul_pd(_mm_mul_pd(w, w2), p));
+
+            // NaN lanes index the table with garbage, so they are cleared to 0 first and restored below.
+            __m128d nan = _mm_cmpunord_pd(v, v);
+            __m128i index = _mm_cvtpd_epi32(_mm_andnot_pd(nan, kIndex));
+            __m128d centre = _mm_set_pd(table[_mm_cvtsi128_si32(_mm_shuffle_epi32(index, 1))],
+                                        table[_mm_cvtsi128_si32(index)]);
+            __m128d phi = _mm_mul_pd(two, _mm_add_pd(centre, atanW));
+            phi = _mm_or_pd(phi, _mm_and_pd(v, signMask));
+            phi = _mm_or_pd(_mm_and_pd(nan, v), _mm_andnot_pd(nan, phi));
+
+            _mm_storeu_pd(longitude+k, _mm_mul_pd(_mm_div_pd(_mm_mul_pd(xV, sf), radius), radToDeg));
+            _mm_storeu_pd(latitude+k, _mm_mul_pd(phi, radToDeg));
+        }
+        return k;
+    }
+#endif
+
+    /**
+     * @brief DEG_TO_RAD and RAD_TO_DEG convert between degrees and radians like qDegreesToRadians() and
+     * qRadiansToDegrees().
+     */
+    static constexpr double DEG_TO_RAD = M_PI/180;
+    static constexpr double RAD_TO_DEG = 180/M_PI;
+
+    /**
+     * @brief LATITUDE_LB and LATITUDE_UB limit the latitudes of the projection.
+     */
+    static constexpr double LATITUDE_LB = 2.5*2.0-90.0;
+    static constexpr double LATITUDE_UB = 87.5*2.0-90.0;
+
+    /**
+     * @brief LN2_HI and LN2_LO split ln(2), so that LN2_HI times an exponent is exact. LOG2_E is 1/ln(2).
+     */
+    static constexpr double LN2_HI = 6.93147180369123816490e-01;
+    static constexpr double LN2_LO = 1.90821492927058770002e-10;
+    static constexpr double LOG2_E = 1.4426950408889634;
+    static constexpr double SQRT_2 = 1.4142135623730951;
+
+    /**
+     * @brief EXP_ARGUMENT_LIMIT bounds the argument of exp, beyond which tanh(a/2) is 1 in double precision.
+     */
+    static constexpr double EXP_ARGUMENT_LIMIT = 40.0;
+
+    /**
+     * @brief ATAN_STEPS is the number of tabulated atan centres in (0, 1].
+     */
+    static constexpr double ATAN_STEPS = 4.0;
+
+    /**
+     * @brief MANTISSA_MASK and ONE_BITS are the mantissa bits of a double and the bits of 1.0.
+     */
+    static const uint64_t MANTISSA_MASK = 0x000FFFFFFFFFFFFFULL;
+    static const uint64_t ONE_BITS = 0x3FF0000000000000ULL;
+
+    /**
+     * @brief SIN_TERMS, LOG_TERMS, EXP_TERMS and ATAN_TERMS are the numbers of polynomial coefficients.
+     */
+    static const int SIN_TERMS = 10;
+    static const int LOG_TERMS = 11;
+    static const int EXP_TERMS = 14;
+    static const int ATAN_TERMS = 9;
+};
+
+#endif // MERCATORKERNEL_H
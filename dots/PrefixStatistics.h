@@ -0,0 +1,689 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief PrefixStatistics.h defines the PrefixStatistics class.
+  * @author caoweiquan322
+  */
+#ifndef PREFIXSTATISTICS_H
+#define PREFIXSTATISTICS_H
+
+#include<cstdlib>
+#include<cstring>
+#include<cstdint>
+#include<new>
+#include<stdexcept>
+#include"BinaryStream.h"
+#include"LssdKernel.h"
+
+/**
+ * @brief The PrefixStatisticsT class stores a trajectory in N spatial dimensions together with the running sums LSSD is
+ * calculated from.
+ *
+ * Each point is one record holding its position, its timestamp and the 3N+2 prefix sums up to it. The records live in
+ * a single cache-aligned allocation that grows geometrically, so appending a point costs at most one reallocation
+ * and LSSD between two points loads the record of the first point and two adjacent records of the last point.
+ *
+ * Positions and timestamps are stored relative to a local origin, which is the first point and moves to the first
+ * retained point whenever the front is dropped, so absolute inputs like projected meters and Unix epoch seconds lose
+ * no precision to their offset. The origin alone does not keep the prefix sums small though: they grow with the
+ * number of points times their squared distance to the origin, and rounding them to one scalar would leave an error
+ * of a long trajectory far above the LSSD of a short segment at its end. Each prefix sum is therefore kept as an
+ * unevaluated sum of a high and a low part, the low part collecting the rounding error of every addition (TwoSum).
+ * The difference of two prefix sums, which is all LSSD needs, is then accurate to the rounding of the difference
+ * itself however long the trajectory is. What remains is the shift of the inner points to the first point of the
+ * segment (see LssdKernelT), whose error grows like the number of inner points times their squared distance to the
+ * origin times 2^-53.
+ *
+ * Scalar is the type the records are stored in, while the origin and LSSD are always double. Storing float halves
+ * the memory and bandwidth of the records, but positions relative to the origin then carry 24 bits and the shift of
+ * the inner points leaves an error of the number of inner points times their squared distance to the origin times
+ * 2^-24. It is for data whose retained window is small, e.g. streaming mode (which moves the origin) over city-scale
+ * extents, and double is the safe default.
+ *
+ * The class is header-only and depends on the standard library only, as it is part of the DOTS core (see DotsCoreT).
+ */
+template<int N, typename Scalar>
+class PrefixStatisticsT
+{
+public:
+    /**
+     * @brief PrefixStatisticsT constructs an empty container.
+     */
+    PrefixStatisticsT()
+    {
+        records = NULL;
+        block = NULL;
+        size = 0;
+        capacity = 0;
+        resetOrigin();
+    }
+
+    /**
+     * @brief PrefixStatisticsT constructs the statistics of a whole 2D trajectory.
+     * @param x is the x values of trajectory points.
+     * @param y is the y values of trajectory points.
+     * @param t is the timestamps of trajectory points.
+     * @param n is the number of trajectory points.
+     */
+    PrefixStatisticsT(const double *x, const double *y, const double *t, int n)
+    {
+        records = NULL;
+        block = NULL;
+        size = 0;
+        capacity = 0;
+        resetOrigin();
+        append(x, y, t, n);
+    }
+
+    /**
+     * @brief PrefixStatisticsT constructs the statistics of a whole trajectory.
+     * @param position is the positions of trajectory points along each axis, i.e. position[a][k] is the position of
+     * the k-th point along axis a.
+     * @param t is the timestamps of trajectory points.
+     * @param n is the number of trajectory points.
+     */
+    PrefixStatisticsT(const double *const *position, const double *t, int n)
+    {
+        records = NULL;
+        block = NULL;
+        size = 0;
+        capacity = 0;
+        resetOrigin();
+        append(position, t, n);
+    }
+
+    /**
+     * @brief PrefixStatisticsT is the copy constructor.
+     * @param other is the container to copy.
+     */
+    PrefixStatisticsT(const PrefixStatisticsT &other)
+    {
+        records = NULL;
+        block = NULL;
+        size = 0;
+        capacity = 0;
+        resetOrigin();
+        *this = other;
+    }
+
+    /**
+     * @brief PrefixStatisticsT is the move constructor. The other container is left empty.
+     * @param other is the container to move.
+     */
+    PrefixStatisticsT(PrefixStatisticsT &&other)
+    {
+        records = NULL;
+        block = NULL;
+        size = 0;
+        capacity = 0;
+        resetOrigin();
+        *this = static_cast<PrefixStatisticsT &&>(other);
+    }
+
+    /**
+     * @brief operator = copies another container.
+     * @param other is the container to copy.
+     * @return this container.
+     */
+    PrefixStatisticsT &operator=(const PrefixStatisticsT &other)
+    {
+        if (this != &other)
+        {
+            size = 0;
+            reserve(other.size);
+            if (other.size > 0)
+                memcpy(records, other.records, sizeof(Record)*other.size);
+            size = other.size;
+            copyOrigin(other);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief operator = moves another container. The other container is left empty.
+     * @param other is the container to move.
+     * @return this container.
+     */
+    PrefixStatisticsT &operator=(PrefixStatisticsT &&other)
+    {
+        if (this != &other)
+        {
+            free(block);
+            records = other.records;
+            block = other.block;
+            size = other.size;
+            capacity = other.capacity;
+            copyOrigin(other);
+            other.records = NULL;
+            other.block = NULL;
+            other.size = 0;
+            other.capacity = 0;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief the deconstructor.
+     */
+    ~PrefixStatisticsT()
+    {
+        free(block);
+    }
+
+    /**
+     * @brief clear removes all points.
+     */
+    inline void clear()
+    {
+        size = 0;
+    }
+
+    /**
+     * @brief reserve allocates space for at least n points.
+     * @param n is the number of points.
+     */
+    void reserve(int n)
+    {
+        if (n <= capacity)
+            return;
+
+        // Over-allocate to align the records at a cache line.
+        void *newBlock = malloc(sizeof(Record)*n+ALIGNMENT);
+        if (newBlock == NULL)
+            throw std::bad_alloc();
+        Record *newRecords = reinterpret_cast<Record *>(
+                    (reinterpret_cast<uintptr_t>(newBlock)+ALIGNMENT-1) & ~static_cast<uintptr_t>(ALIGNMENT-1));
+        if (size > 0)
+            memcpy(newRecords, records, sizeof(Record)*size);
+        free(block);
+        block = newBlock;
+        records = newRecords;
+        capacity = n;
+    }
+
+    /**
+     * @brief append appends a 2D point and updates the prefix sums.
+     * @param x is the x position.
+     * @param y is the y position.
+     * @param t is the timestamp.
+     */
+    inline void append(double x, double y, double t)
+    {
+        static_assert(N == 2, "Positions of this dimension are appended by append(position, t).");
+        const double position[2] = {x, y};
+        append(position, t);
+    }
+
+    /**
+     * @brief append appends a point and updates the prefix sums.
+     * @param position is the position along each axis.
+     * @param t is the timestamp.
+     */
+    inline void append(const double *position, double t)
+    {
+        if (size == capacity)
+            reserve(capacity < MIN_CAPACITY ? MIN_CAPACITY : capacity*2);
+        if (size == 0)
+        {
+            for (int a=0; a<N; ++a)
+                origin[a] = position[a];
+            originT = t;
+        }
+
+        Record &r = records[size];
+        for (int a=0; a<N; ++a)
+            r.x[a] = static_cast<Scalar>(position[a]-origin[a]);
+        r.t = static_cast<Scalar>(t-originT);
+        accumulate(size);
+        ++size;
+    }
+
+    /**
+     * @brief append appends n 2D points and updates the prefix sums.
+     * @param x is the x positions.
+     * @param y is the y positions.
+     * @param t is the timestamps.
+     * @param n is the number of points.
+     */
+    void append(const double *x, const double *y, const double *t, int n)
+    {
+        static_assert(N == 2, "Positions of this dimension are appended by append(position, t, n).");
+        const double *position[2] = {x, y};
+        append(position, t, n);
+    }
+
+    /**
+     * @brief append appends n points and updates the prefix sums. Space is reserved once, and the prefix sums are
+     * carried in registers instead of being reloaded from the preceding record. The results are the same as appending
+     * the points one by one.
+     * @param position is the positions along each axis, i.e. position[a][k] is the position of the k-th point along
+     * axis a.
+     * @param t is the timestamps.
+     * @param n is the number of points.
+     */
+    void append(const double *const *position, const double *t, int n)
+    {
+        if (n <= 0)
+            return;
+        if (size+n > capacity)
+        {
+            int grown = capacity < MIN_CAPACITY ? MIN_CAPACITY : capacity*2;
+            reserve(size+n > grown ? size+n : grown);
+        }
+        if (size == 0)
+        {
+            for (int a=0; a<N; ++a)
+                origin[a] = position[a][0];
+            originT = t[0];
+        }
+
+        // Positions relative to the local origin.
+        Record *r = records+size;
+        for (int k=0; k<n; ++k)
+        {
+            for (int a=0; a<N; ++a)
+                r[k].x[a] = static_cast<Scalar>(position[a][k]-origin[a]);
+            r[k].t = static_cast<Scalar>(t[k]-originT);
+        }
+
+        // Compensated prefix sums.
+        Scalar xSum[N], tSum = 0, x2Sum[N], t2Sum = 0, xtSum[N];
+        Scalar xSumLo[N], tSumLo = 0, x2SumLo[N], t2SumLo = 0, xtSumLo[N];
+        for (int a=0; a<N; ++a)
+            xSum[a] = x2Sum[a] = xtSum[a] = xSumLo[a] = x2SumLo[a] = xtSumLo[a] = 0;
+        if (size > 0)
+        {
+            const Record &p = records[size-1];
+            for (int a=0; a<N; ++a)
+            {
+                xSum[a] = p.xSum[a];
+                x2Sum[a] = p.x2Sum[a];
+                xtSum[a] = p.xtSum[a];
+                xSumLo[a] = p.xSumLo[a];
+                x2SumLo[a] = p.x2SumLo[a];
+                xtSumLo[a] = p.xtSumLo[a];
+            }
+            tSum = p.tSum;
+            t2Sum = p.t2Sum;
+            tSumLo = p.tSumLo;
+            t2SumLo = p.t2SumLo;
+        }
+        for (int k=0; k<n; ++k)
+        {
+            Record &q = r[k];
+            for (int a=0; a<N; ++a)
+            {
+                q.xSum[a] = add(xSum[a], xSumLo[a], q.x[a]);
+                q.x2Sum[a] = add(x2Sum[a], x2SumLo[a], q.x[a]*q.x[a]);
+                q.xtSum[a] = add(xtSum[a], xtSumLo[a], q.x[a]*q.t);
+                q.xSumLo[a] = xSumLo[a];
+                q.x2SumLo[a] = x2SumLo[a];
+                q.xtSumLo[a] = xtSumLo[a];
+            }
+            q.tSum = add(tSum, tSumLo, q.t);
+            q.t2Sum = add(t2Sum, t2SumLo, q.t*q.t);
+            q.tSumLo = tSumLo;
+            q.t2SumLo = t2SumLo;
+        }
+        size += n;
+    }
+
+    /**
+     * @brief removeFirst drops the first n points, moves the local origin to the first retained point and rebuilds the
+     * prefix sums relative to it. LSSD of retained points is not affected as it is invariant to translations.
+     * @param n is the number of points to drop.
+     */
+    void removeFirst(int n)
+    {
+        if (n <= 0)
+            return;
+        if (n >= size)
+        {
+            size = 0;
+            return;
+        }
+
+        size -= n;
+        memmove(records, records+n, sizeof(Record)*size);
+
+        // Move the local origin to the first retained point and rebuild prefix sums relative to it.
+        Scalar dx[N], dt = records[0].t;
+        for (int a=0; a<N; ++a)
+        {
+            dx[a] = records[0].x[a];
+            origin[a] += dx[a];
+        }
+        originT += dt;
+        for (int k=0; k<size; ++k)
+        {
+            Record &r = records[k];
+            for (int a=0; a<N; ++a)
+                r.x[a] -= dx[a];
+            r.t -= dt;
+            accumulate(k);
+        }
+    }
+
+
+    /**
+     * @brief count retrieves the number of points.
+     * @return the number of points.
+     */
+    inline int count() const
+    {
+        return size;
+    }
+
+    /**
+     * @brief position retrieves the position of the k-th point along axis a.
+     */
+    inline double position(int k, int a) const
+    {
+        return origin[a]+records[k].x[a];
+    }
+
+    /**
+     * @brief x retrieves x position of the k-th point.
+     */
+    inline double x(int k) const
+    {
+        return position(k, 0);
+    }
+
+    /**
+     * @brief y retrieves y position of the k-th point.
+     */
+    inline double y(int k) const
+    {
+        return position(k, 1);
+    }
+
+    /**
+     * @brief t retrieves timestamp of the k-th point.
+     */
+    inline double t(int k) const
+    {
+        return originT+records[k].t;
+    }
+
+    /**
+     * @brief getFirstPoint gathers statistics of the k-th point as the first point of a segment. Positions and
+     * timestamps are relative to the local origin.
+     * @param k is index of the point.
+     * @param p receives the statistics.
+     */
+    inline void getFirstPoint(int k, LssdPointT<N> &p) const
+    {
+        const Record &r = records[k];
+        p.index = k;
+        for (int a=0; a<N; ++a)
+        {
+            p.x[a] = r.x[a];
+            p.xSum[a] = r.xSum[a];
+            p.x2Sum[a] = r.x2Sum[a];
+            p.xtSum[a] = r.xtSum[a];
+            p.xSumLo[a] = r.xSumLo[a];
+            p.x2SumLo[a] = r.x2SumLo[a];
+            p.xtSumLo[a] = r.xtSumLo[a];
+        }
+        p.t = r.t;
+        p.tSum = r.tSum;
+        p.t2Sum = r.t2Sum;
+        p.tSumLo = r.tSumLo;
+        p.t2SumLo = r.t2SumLo;
+    }
+
+    /**
+     * @brief getLastPoint gathers statistics of the k-th point as the last point of a segment. The prefix sums are
+     * taken from the preceding point, which is adjacent in memory. Positions and timestamps are relative to the local
+     * origin. Note that k must be positive.
+     * @param k is index of the point.
+     * @param p receives the statistics.
+     */
+    inline void getLastPoint(int k, LssdPointT<N> &p) const
+    {
+        const Record &r = records[k];
+        const Record &s = records[k-1];
+        p.index = k-1;
+        for (int a=0; a<N; ++a)
+        {
+            p.x[a] = r.x[a];
+            p.xSum[a] = s.xSum[a];
+            p.x2Sum[a] = s.x2Sum[a];
+            p.xtSum[a] = s.xtSum[a];
+            p.xSumLo[a] = s.xSumLo[a];
+            p.x2SumLo[a] = s.x2SumLo[a];
+            p.xtSumLo[a] = s.xtSumLo[a];
+        }
+        p.t = r.t;
+        p.tSum = s.tSum;
+        p.t2Sum = s.t2Sum;
+        p.tSumLo = s.tSumLo;
+        p.t2SumLo = s.t2SumLo;
+    }
+
+    /**
+     * @brief lssd calculates the LSSD between the fst-th and the lst-th points.
+     * @param fst is index of the first point.
+     * @param lst is index of the last point.
+     * @return the LSSD distance.
+     */
+    inline double lssd(int fst, int lst) const
+    {
+        if (fst+1>=lst)
+            return 0;
+
+        LssdPointT<N> f, l;
+        getFirstPoint(fst, f);
+        getLastPoint(lst, l);
+        return LssdKernelT<N>::lssd(f, l);
+    }
+
+    /**
+     * @brief save writes the dimension, the size of Scalar, the local origin and the records from the first-th point
+     * on. The prefix sums are written as they are rather than recomputed on load, so a loaded container evaluates LSSD
+     * bit for bit like this one.
+     * @param writer is the writer.
+     * @param first is index of the first point to write.
+     */
+    void save(BinaryWriter &writer, int first) const
+    {
+        writer.write(N);
+        writer.write(static_cast<int>(sizeof(Scalar)));
+        for (int a=0; a<N; ++a)
+            writer.write(origin[a]);
+        writer.write(originT);
+        writer.write(size-first);
+        for (int k=first; k<size; ++k)
+        {
+            const Record &r = records[k];
+            for (int a=0; a<N; ++a)
+                writer.write(r.x[a]);
+            writer.write(r.t);
+            for (int a=0; a<N; ++a)
+                writer.write(r.xSum[a]);
+            writer.write(r.tSum);
+            for (int a=0; a<N; ++a)
+                writer.write(r.x2Sum[a]);
+            writer.write(r.t2Sum);
+            for (int a=0; a<N; ++a)
+                writer.write(r.xtSum[a]);
+            for (int a=0; a<N; ++a)
+                writer.write(r.xSumLo[a]);
+            writer.write(r.tSumLo);
+            for (int a=0; a<N; ++a)
+                writer.write(r.x2SumLo[a]);
+            writer.write(r.t2SumLo);
+            for (int a=0; a<N; ++a)
+                writer.write(r.xtSumLo[a]);
+        }
+    }
+
+    /**
+     * @brief load replaces the content by what save() wrote. The dimension and Scalar must be the same as those of the
+     * container that saved it.
+     * @param reader is the reader.
+     */
+    void load(BinaryReader &reader)
+    {
+        clear();
+        if (reader.read<int>() != N || reader.read<int>() != static_cast<int>(sizeof(Scalar)))
+            throw std::runtime_error("The binary data was written by statistics of another dimension or scalar type.");
+        for (int a=0; a<N; ++a)
+            origin[a] = reader.read<double>();
+        originT = reader.read<double>();
+        int n = reader.read<int>();
+        if (n < 0)
+            throw std::runtime_error("Corrupted or truncated binary data.");
+        reserve(n);
+        for (int k=0; k<n; ++k)
+        {
+            Record &r = records[k];
+            for (int a=0; a<N; ++a)
+                r.x[a] = reader.read<Scalar>();
+            r.t = reader.read<Scalar>();
+            for (int a=0; a<N; ++a)
+                r.xSum[a] = reader.read<Scalar>();
+            r.tSum = reader.read<Scalar>();
+            for (int a=0; a<N; ++a)
+                r.x2Sum[a] = reader.read<Scalar>();
+            r.t2Sum = reader.read<Scalar>();
+            for (int a=0; a<N; ++a)
+                r.xtSum[a] = reader.read<Scalar>();
+            for (int a=0; a<N; ++a)
+                r.xSumLo[a] = reader.read<Scalar>();
+            r.tSumLo = reader.read<Scalar>();
+            for (int a=0; a<N; ++a)
+                r.x2SumLo[a] = reader.read<Scalar>();
+            r.t2SumLo = reader.read<Scalar>();
+            for (int a=0; a<N; ++a)
+                r.xtSumLo[a] = reader.read<Scalar>();
+            size = k+1;
+        }
+    }
+
+protected:
+    /**
+     * @brief add adds a value to a compensated sum. The rounding error of the addition is recovered exactly (TwoSum)
+     * and collected in the low part.
+     * @param sum is the high part of the sum.
+     * @param lo is the low part of the sum.
+     * @param value is the value to add.
+     * @return the new high part.
+     */
+    static inline Scalar add(Scalar &sum, Scalar &lo, Scalar value)
+    {
+        Scalar s = sum+value;
+        Scalar v = s-sum;
+        lo += (sum-(s-v))+(value-v);
+        return sum = s;
+    }
+
+    /**
+     * @brief accumulate calculates the prefix sums of the k-th record from its position and the preceding record.
+     * @param k is index of the record.
+     */
+    inline void accumulate(int k)
+    {
+        Record &r = records[k];
+        if (k == 0)
+        {
+            for (int a=0; a<N; ++a)
+            {
+                r.xSum[a] = r.x[a];
+                r.x2Sum[a] = r.x[a]*r.x[a];
+                r.xtSum[a] = r.x[a]*r.t;
+                r.xSumLo[a] = r.x2SumLo[a] = r.xtSumLo[a] = 0;
+            }
+            r.tSum = r.t;
+            r.t2Sum = r.t*r.t;
+            r.tSumLo = r.t2SumLo = 0;
+        }
+        else
+        {
+            const Record &p = records[k-1];
+            for (int a=0; a<N; ++a)
+            {
+                r.xSum[a] = p.xSum[a];
+                r.x2Sum[a] = p.x2Sum[a];
+                r.xtSum[a] = p.xtSum[a];
+                r.xSumLo[a] = p.xSumLo[a];
+                r.x2SumLo[a] = p.x2SumLo[a];
+                r.xtSumLo[a] = p.xtSumLo[a];
+                add(r.xSum[a], r.xSumLo[a], r.x[a]);
+                add(r.x2Sum[a], r.x2SumLo[a], r.x[a]*r.x[a]);
+                add(r.xtSum[a], r.xtSumLo[a], r.x[a]*r.t);
+            }
+            r.tSum = p.tSum;
+            r.t2Sum = p.t2Sum;
+            r.tSumLo = p.tSumLo;
+            r.t2SumLo = p.t2SumLo;
+            add(r.tSum, r.tSumLo, r.t);
+            add(r.t2Sum, r.t2SumLo, r.t*r.t);
+        }
+    }
+
+    /**
+     * @brief resetOrigin moves the local origin to zero.
+     */
+    inline void resetOrigin()
+    {
+        for (int a=0; a<N; ++a)
+            origin[a] = 0;
+        originT = 0;
+    }
+
+    /**
+     * @brief copyOrigin copies the local origin of another container.
+     * @param other is the other container.
+     */
+    inline void copyOrigin(const PrefixStatisticsT &other)
+    {
+        for (int a=0; a<N; ++a)
+            origin[a] = other.origin[a];
+        originT = other.originT;
+    }
+
+    /**
+     * @brief The Record class is the statistics of one point, where x[a] is the position along axis a and every prefix
+     * sum is the sum of its high part and the low part of the same name with suffix Lo. It is padded to a multiple of
+     * four scalars, e.g. 160 bytes in 2D double, to keep every record aligned like a SIMD vector of four scalars.
+     */
+    class alignas(4*sizeof(Scalar)) Record {
+    public:
+        Scalar x[N], t;
+        Scalar xSum[N], tSum, x2Sum[N], t2Sum, xtSum[N];
+        Scalar xSumLo[N], tSumLo, x2SumLo[N], t2SumLo, xtSumLo[N];
+    };
+
+    /**
+     * @brief ALIGNMENT is the alignment of the record block, i.e. the size of a cache line.
+     */
+    static const int ALIGNMENT = 64;
+
+    /**
+     * @brief MIN_CAPACITY is the number of records allocated by the first append.
+     */
+    static const int MIN_CAPACITY = 64;
+
+    // Aligned records within the allocated block.
+    Record *records;
+    void *block;
+    int size;
+    int capacity;
+
+    // The local origin.
+    double origin[N], originT;
+};
+
+/**
+ * @brief PrefixStatistics is the 2D double instantiation.
+ */
+typedef PrefixStatisticsT<2, double> PrefixStatistics;
+
+#endif // PREFIXSTATISTICS_H
@@ -0,0 +1,129 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief SpscQueue.h defines the SpscQueue class, a lock-free ring buffer between two threads.
+  * @author caoweiquan322
+  */
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include<atomic>
+#include<cstddef>
+#include<thread>
+#include<vector>
+
+/**
+ * @brief The SpscQueue class is a bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * The producer publishes an element by a release store of the tail, and the consumer acquires it by loading the tail,
+ * so everything the producer wrote before pushing (e.g. the input data an index refers to) is visible to the consumer
+ * once it pops the element. Each side caches the position of the other side to avoid touching its cache line on every
+ * operation. The blocking push() and pop() spin and yield, which suits pipelines whose stages are always busy.
+ */
+template<typename T>
+class SpscQueue
+{
+public:
+    /**
+     * @brief SpscQueue constructs an empty queue.
+     * @param capacity is the minimum number of elements the queue holds. It is rounded up to a power of two.
+     */
+    explicit SpscQueue(size_t capacity = 4096) : head(0), cachedTail(0), tail(0), cachedHead(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size *= 2;
+        buffer.resize(size);
+        mask = size-1;
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    /**
+     * @brief tryPush appends an element unless the queue is full. It must be called by the producer only.
+     * @param value is the element.
+     * @return true if the element was appended, false if the queue is full.
+     */
+    inline bool tryPush(const T &value)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t-cachedHead > mask)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t-cachedHead > mask)
+                return false;
+        }
+        buffer[t & mask] = value;
+        tail.store(t+1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief tryPop removes the first element unless the queue is empty. It must be called by the consumer only.
+     * @param value receives the element.
+     * @return true if an element was removed, false if the queue is empty.
+     */
+    inline bool tryPop(T &value)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail)
+                return false;
+        }
+        value = buffer[h & mask];
+        head.store(h+1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief push appends an element, waiting while the queue is full.
+     * @param value is the element.
+     */
+    inline void push(const T &value)
+    {
+        while (!tryPush(value))
+            std::this_thread::yield();
+    }
+
+    /**
+     * @brief pop removes the first element, waiting while the queue is empty.
+     * @return the element.
+     */
+    inline T pop()
+    {
+        T value;
+        while (!tryPop(value))
+            std::this_thread::yield();
+        return value;
+    }
+
+protected:
+    /**
+     * @brief CACHE_LINE is the size of a cache line. The positions of the two sides are kept apart by it.
+     */
+    static const size_t CACHE_LINE = 64;
+
+    std::vector<T> buffer;
+    size_t mask;
+    char padding0[CACHE_LINE];
+
+    // Consumer side: the position to pop at and the last tail it saw.
+    std::atomic<size_t> head;
+    size_t cachedTail;
+    char padding1[CACHE_LINE];
+
+    // Producer side: the position to push at and the last head it saw.
+    std::atomic<size_t> tail;
+    size_t cachedHead;
+    char padding2[CACHE_LINE];
+};
+
+#endif // SPSCQUEUE_H
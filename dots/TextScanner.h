@@ -0,0 +1,266 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief TextScanner.h defines the TextScanner class used by the trajectory file parsers of Helper.
+  * @author caoweiquan322
+  */
+#ifndef TEXTSCANNER_H
+#define TEXTSCANNER_H
+
+#include<cstdint>
+#include<cstring>
+#if defined(__SSE2__) || defined(_M_X64)
+#include<emmintrin.h>
+#endif
+
+/**
+ * @brief The TextField class is a range of characters within a text buffer.
+ */
+class TextField {
+public:
+    const char *begin;
+    const char *end;
+
+    /**
+     * @brief length retrieves the number of characters.
+     */
+    inline int length() const
+    {
+        return static_cast<int>(end-begin);
+    }
+};
+
+/**
+ * @brief The TextScanner class scans the lines and fields of a text buffer in place, e.g. of a memory-mapped file.
+ * Lines and fields are ranges of the buffer, so nothing is copied or allocated per line.
+ *
+ * Lines are separated by '\n' and are trimmed of white space on both ends, which also removes the '\r' of "\r\n"
+ * line ends. This gives the same lines as QIODevice::readLine() followed by QByteArray::trimmed().
+ *
+ * The class is header-only and depends on the standard library only.
+ */
+class TextScanner
+{
+public:
+    /**
+     * @brief TextScanner constructs a scanner of a character range.
+     * @param begin is the first character.
+     * @param end is one past the last character.
+     */
+    TextScanner(const char *begin, const char *end) : pos(begin), end(end)
+    {
+    }
+
+    /**
+     * @brief nextLine retrieves the next line without surrounding white space. Empty lines are retrieved as empty
+     * fields.
+     * @param line receives the line.
+     * @return true if there was a line, false at the end of the buffer.
+     */
+    inline bool nextLine(TextField &line)
+    {
+        if (pos >= end)
+            return false;
+
+        const char *lineEnd = static_cast<const char *>(memchr(pos, '\n', end-pos));
+        if (lineEnd == NULL)
+            lineEnd = end;
+        line.begin = pos;
+        line.end = lineEnd;
+        pos = (lineEnd < end) ? lineEnd+1 : end;
+
+        while (line.begin < line.end && isSpace(*line.begin))
+            ++line.begin;
+        while (line.end > line.begin && isSpace(line.end[-1]))
+            --line.end;
+        return true;
+    }
+
+    /**
+     * @brief countLines counts the lines of a character range, e.g. to reserve space for the parsed data at once.
+     * @param begin is the first character.
+     * @param end is one past the last character.
+     * @return the number of lines, where a last line without '\n' counts as well.
+     */
+    static int countLines(const char *begin, const char *end)
+    {
+        int count = 0;
+        const char *pos = begin;
+        while (pos < end)
+        {
+            const char *lineEnd = static_cast<const char *>(memchr(pos, '\n', end-pos));
+            ++count;
+            if (lineEnd == NULL)
+                break;
+            pos = lineEnd+1;
+        }
+        return count;
+    }
+
+    /**
+     * @brief split cuts a line at each separator, like QByteArray::split() does, i.e. adjacent separators enclose
+     * an empty field.
+     * @param line is the line.
+     * @param separator is the separator.
+     * @param fields receives the first maxFields fields.
+     * @param maxFields is the capacity of fields.
+     * @return the number of fields, which may be more than maxFields.
+     */
+    static inline int split(const TextField &line, char separator, TextField *fields, int maxFields)
+    {
+        int count = 0;
+        const char *pos = line.begin;
+        for (;;)
+        {
+            const char *fieldEnd = static_cast<const char *>(memchr(pos, separator, line.end-pos));
+            if (fieldEnd == NULL)
+                fieldEnd = line.end;
+            if (count < maxFields)
+            {
+                fields[count].begin = pos;
+                fields[count].end = fieldEnd;
+            }
+            ++count;
+            if (fieldEnd == line.end)
+                return count;
+            pos = fieldEnd+1;
+        }
+    }
+
+    /**
+     * @brief parseDouble converts a plain decimal like "-12.345" exactly as strtod() would. Numbers in other forms,
+     * e.g. with an exponent or a sign of '+', or with more digits than a double holds, are left to the caller.
+     *
+     * The digits form an integer m of at most 2^53 and the decimal point divides it by 10^d with d <= 22. Both are exactly
+     * representable doubles, so the single division is correctly rounded, like strtod().
+     * @param field is the text of the number.
+     * @param value receives the number.
+     * @return true if the number was converted, false if it is not a plain decimal the fast path handles.
+     */
+    static inline bool parseDouble(const TextField &field, double &value)
+    {
+        const char *pos = field.begin;
+        bool negative = (pos < field.end && *pos == '-');
+        if (negative)
+            ++pos;
+
+        uint64_t mantissa = 0;
+        int digits = 0, decimals = 0;
+        const char *intEnd = pos;
+        while (intEnd < field.end && isDigit(*intEnd))
+        {
+            mantissa = mantissa*10+static_cast<unsigned>(*intEnd-'0');
+            ++intEnd;
+        }
+        digits = static_cast<int>(intEnd-pos);
+        if (digits == 0)
+            return false;
+
+        pos = intEnd;
+        if (pos < field.end && *pos == '.')
+        {
+            const char *fracEnd = ++pos;
+            while (fracEnd < field.end && isDigit(*fracEnd))
+            {
+                mantissa = mantissa*10+static_cast<unsigned>(*fracEnd-'0');
+                ++fracEnd;
+            }
+            decimals = static_cast<int>(fracEnd-pos);
+            if (decimals == 0)
+                return false;
+            digits += decimals;
+            pos = fracEnd;
+        }
+
+        // Up to 19 digits cannot overflow the mantissa, and the exactness bounds are checked on the result.
+        if (pos != field.end || digits > 19 || mantissa > MAX_EXACT_MANTISSA || decimals > MAX_EXACT_DECIMALS)
+            return false;
+
+        double result = static_cast<double>(mantissa);
+        if (decimals > 0)
+            result /= powerOfTen(decimals);
+        value = negative ? -result : result;
+        return true;
+    }
+
+    /**
+     * @brief isDateTime checks if 19 characters have the form "yyyy-MM-dd?HH:mm:ss" of digits and separators, where
+     * '?' is any character, e.g. the one separating the date field from the time field. With SSE2 the first 16
+     * characters are checked at once. The ranges of the values are not checked.
+     * @param text is the first character. 19 characters must be readable from it.
+     * @return true if the characters have the form, false otherwise.
+     */
+    static inline bool isDateTime(const char *text)
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+        __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+        int digits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d));
+        int separators = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setr_epi8(0, 0, 0, 0, '-', 0, 0, '-', 0, 0, 0, 0, 0,
+                                                                            ':', 0, 0)));
+        if ((digits & DATE_TIME_DIGITS) != DATE_TIME_DIGITS
+                || (separators & DATE_TIME_SEPARATORS) != DATE_TIME_SEPARATORS)
+            return false;
+        return text[16] == ':' && isDigit(text[17]) && isDigit(text[18]);
+#else
+        // '0' stands for a digit and '?' for any character.
+        static const char PATTERN[] = "0000-00-00?00:00:00";
+        for (int k=0; k<19; ++k)
+        {
+            if (PATTERN[k] == '0' ? !isDigit(text[k]) : (PATTERN[k] != '?' && PATTERN[k] != text[k]))
+                return false;
+        }
+        return true;
+#endif
+    }
+
+    /**
+     * @brief isDigit checks if a character is a decimal digit.
+     */
+    static inline bool isDigit(char c)
+    {
+        return static_cast<unsigned>(c-'0') < 10;
+    }
+
+    /**
+     * @brief isSpace checks if a character is white space in the sense of QByteArray::trimmed().
+     */
+    static inline bool isSpace(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+protected:
+    /**
+     * @brief powerOfTen retrieves 10^d for d in [0, MAX_EXACT_DECIMALS], which are exactly representable doubles.
+     */
+    static inline double powerOfTen(int d)
+    {
+        static const double POWERS[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+                                        1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        return POWERS[d];
+    }
+
+    /**
+     * @brief MAX_EXACT_MANTISSA and MAX_EXACT_DECIMALS bound the plain decimals parseDouble() converts exactly.
+     */
+    static const uint64_t MAX_EXACT_MANTISSA = (1ULL << 53);
+    static const int MAX_EXACT_DECIMALS = 22;
+
+    /**
+     * @brief DATE_TIME_DIGITS and DATE_TIME_SEPARATORS are the bits of the digits and of the '-' and ':' separators
+     * among the first 16 characters of "yyyy-MM-dd?HH:mm:ss".
+     */
+    static const int DATE_TIME_DIGITS = 0xDB6F;
+    static const int DATE_TIME_SEPARATORS = 0x2090;
+
+    const char *pos;
+    const char *end;
+};
+
+#endif // TEXTSCANNER_H
@@ -0,0 +1,106 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+#include "TrajectoryReader.h"
+#include"DotsException.h"
+#include"Helper.h"
+
+const double TrajectoryReader::GEOLIFE_INVALID_ALTITUDE = -777;
+const double TrajectoryReader::FEET_TO_METERS = 0.3048;
+
+TrajectoryReader::Format TrajectoryReader::formatOf(QString fileName)
+{
+    if (fileName.endsWith(".txt")) // MOPSI dataset.
+        return FORMAT_MOPSI;
+    else if (fileName.endsWith(".plt")) // GeoLife dataset.
+        return FORMAT_GEOLIFE;
+    else if (fileName.endsWith(".csv")) // MIT Single Camera View.
+        return FORMAT_MIT_SCV;
+    else
+        return FORMAT_MOPSI2;
+}
+
+TrajectoryReader::TrajectoryReader(QString fileName, Format format) : file(fileName.trimmed()), scanner(NULL, NULL)
+{
+    // Map the file and scan it in place.
+    Helper::mapFile(file, buffer, begin, end);
+    scanner = TextScanner(begin, end);
+    this->format = format;
+    lineNumber = 0;
+    hasLastT = false;
+    lastT = 0;
+}
+
+bool TrajectoryReader::next(TrajectoryRecord &record)
+{
+    static const int FIELD_COUNTS[] = {4, 4, 7, 3};
+    static const char SEPARATORS[] = {' ', ' ', ',', ','};
+    TextField line, parts[7];
+    while (scanner.nextLine(line))
+    {
+        ++lineNumber;
+        if (format == FORMAT_GEOLIFE && lineNumber <= GEOLIFE_HEADER_LINES)
+            continue;
+        if (line.begin == line.end)
+            continue;
+
+        // In case where the line is malformed.
+        if (TextScanner::split(line, SEPARATORS[format], parts, 7) != FIELD_COUNTS[format])
+        {
+            DotsException("Malformed line found.").raise();
+        }
+
+        // Store the parsed data without cleaning it.
+        double timestamp;
+        switch (format)
+        {
+        case FORMAT_MOPSI:
+            timestamp = decoder.decode(parts[2], parts[3]);
+            break;
+        case FORMAT_MOPSI2:
+            timestamp = Helper::toDouble(parts[2])/1000.0;
+            break;
+        case FORMAT_GEOLIFE:
+            timestamp = Helper::toDouble(parts[4]);
+            timestamp *= (24*3600);
+            break;
+        default:
+            timestamp = Helper::toDouble(parts[2]);
+            break;
+        }
+        if (hasLastT && timestamp-lastT < 1e-15) // Duplicated time point.
+            continue;
+        hasLastT = true;
+        lastT = timestamp;
+        record.t = timestamp;
+
+        if (format == FORMAT_MIT_SCV)
+        {
+            record.x = Helper::toDouble(parts[0]);
+            record.y = Helper::toDouble(parts[1]);
+        }
+        else
+        {
+            record.y = Helper::toDouble(parts[0]);
+            record.x = Helper::toDouble(parts[1]);
+        }
+
+        // Altitude in feet, or -777 if invalid.
+        record.hasZ = false;
+        record.z = 0;
+        if (format == FORMAT_GEOLIFE)
+        {
+            double altitude = Helper::toDouble(parts[3]);
+            if (altitude != GEOLIFE_INVALID_ALTITUDE)
+            {
+                record.hasZ = true;
+                record.z = altitude*FEET_TO_METERS;
+            }
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,131 @@
+/* This software is developed by caoweiquan322 OR DynamicFatty.
+ * All rights reserved.
+ *
+ * Author: caoweiquan322
+ */
+
+/**
+  * @file
+  * @brief TrajectoryReader.h defines the TrajectoryReader class, which reads the records of trajectory text files.
+  * @author caoweiquan322
+  */
+#ifndef TRAJECTORYREADER_H
+#define TRAJECTORYREADER_H
+
+#include<QByteArray>
+#include<QFile>
+#include<QString>
+#include"DateTimeDecoder.h"
+#include"TextScanner.h"
+
+/**
+ * @brief The TrajectoryRecord class is a point of a trajectory file as it is written in the file.
+ */
+class TrajectoryRecord {
+public:
+    // The longitude and latitude in degrees, or the position for formats that are not geographic.
+    double x;
+    double y;
+    // The altitude in meters if hasZ is true, which only GeoLife files have.
+    double z;
+    bool hasZ;
+    // The timestamp in seconds.
+    double t;
+};
+
+/**
+ * @brief The TrajectoryReader class reads the records of a trajectory text file one by one. The file is mapped into
+ * memory and scanned in place, so that the memory a reader takes does not grow with the file, e.g. for streaming the
+ * records through a simplifier. Helper's parsers read the files through it as well.
+ *
+ * Records are returned in file order. Malformed lines raise a DotsException, and records whose timestamp does not
+ * follow the timestamp of the previous record are skipped.
+ */
+class TrajectoryReader
+{
+public:
+    /**
+     * @brief The Format enum lists the supported formats of trajectory text files.
+     */
+    enum Format
+    {
+        // MOPSI files, "latitude longitude yyyy-MM-dd HH:mm:ss" per line. See http://cs.joensuu.fi/mopsi.
+        FORMAT_MOPSI,
+        // MOPSI files of four fields per line, latitude, longitude, a Unix timestamp in milliseconds and one more.
+        FORMAT_MOPSI2,
+        // GeoLife files of Microsoft Research Asia, whose points follow 6 header lines.
+        FORMAT_GEOLIFE,
+        // MIT Single Camera View files, "x,y,timestamp" per line. Their positions are not geographic.
+        FORMAT_MIT_SCV
+    };
+
+    /**
+     * @brief formatOf chooses the format of a file by its suffix: ".txt" for MOPSI, ".plt" for GeoLife, ".csv" for
+     * MIT Single Camera View and MOPSI2 otherwise.
+     * @param fileName is the file name.
+     * @return the format.
+     */
+    static Format formatOf(QString fileName);
+
+    /**
+     * @brief TrajectoryReader opens a trajectory file. A DotsException would be raised if it could not be opened.
+     * @param fileName is the file name.
+     * @param format is the format of the file.
+     */
+    TrajectoryReader(QString fileName, Format format);
+
+    /**
+     * @brief isGeographic checks if the records hold longitude/latitude pairs that need a projection.
+     * @return true for geographic formats, false otherwise.
+     */
+    inline bool isGeographic() const
+    {
+        return format != FORMAT_MIT_SCV;
+    }
+
+    /**
+     * @brief lineCount counts the lines of the file, which bounds the number of records, e.g. to reserve space.
+     * @return the number of lines.
+     */
+    inline int lineCount() const
+    {
+        return TextScanner::countLines(begin, end);
+    }
+
+    /**
+     * @brief next reads the next record.
+     * @param record receives the record.
+     * @return true if there was a record, false at the end of the file.
+     */
+    bool next(TrajectoryRecord &record);
+
+protected:
+    /**
+     * @brief GEOLIFE_HEADER_LINES is the number of lines before the points of a GeoLife file.
+     */
+    static const int GEOLIFE_HEADER_LINES = 6;
+
+    /**
+     * @brief GEOLIFE_INVALID_ALTITUDE marks an invalid altitude in GeoLife data, and FEET_TO_METERS converts its
+     * altitudes to meters.
+     */
+    static const double GEOLIFE_INVALID_ALTITUDE;
+    static const double FEET_TO_METERS;
+
+    // The file and its content, which is mapped or read into buffer.
+    QFile file;
+    QByteArray buffer;
+    const char *begin;
+    const char *end;
+    TextScanner scanner;
+
+    Format format;
+    DateTimeDecoder decoder;
+    // The number of lines scanned so far.
+    int lineNumber;
+    // The timestamp of the previous record, if there was one.
+    bool hasLastT;
+    double lastT;
+};
+
+#endif // TRAJECTORYREADER_H
@@ -3,6 +3,7 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
 
 TARGET = dots
 CONFIG -= console
+CONFIG += c++11 thread
 #CONFIG -= app_bundle
 
 TEMPLATE = app
@@ -18,7 +19,11 @@ SOURCES += main.cpp \
     SquishBatchSimplifier.cpp \
     AlgorithmComparison.cpp \
     OpwTrBatchSimplifier.cpp \
-    OpwBatchSimplifier.cpp
+    OpwBatchSimplifier.cpp \
+    DotsSessionManager.cpp \
+    DateTimeDecoder.cpp \
+    TrajectoryReader.cpp \
+    DotsPipeline.cpp
 
 HEADERS += \
     DotsSimplifier.h \
@@ -32,7 +37,36 @@ HEADERS += \
     SquishBatchSimplifier.h \
     AlgorithmComparison.h \
     OpwTrBatchSimplifier.h \
-    OpwBatchSimplifier.h
+    OpwBatchSimplifier.h \
+    LssdKernel.h \
+    PrefixStatistics.h \
+    BinaryStream.h \
+    DotsSessionManager.h \
+    DotsCore.h \
+    DotsStats.h \
+    SpscQueue.h \
+    DotsStatus.h \
+    TextScanner.h \
+    DateTimeDecoder.h \
+    ColumnCodec.h \
+    TrajectoryReader.h \
+    DotsPipeline.h \
+    MercatorKernel.h
+
+# Hot-path counters and histograms of DotsCore. Enable by "qmake CONFIG+=dots_stats".
+dots_stats {
+    DEFINES += DOTS_STATS
+}
+
+# SIMD LSSD and mercator projection kernels. Enable by "qmake CONFIG+=dots_avx2" or "qmake CONFIG+=dots_avx512".
+dots_avx2 {
+    msvc: QMAKE_CXXFLAGS += /arch:AVX2
+    else: QMAKE_CXXFLAGS += -mavx2
+}
+dots_avx512 {
+    msvc: QMAKE_CXXFLAGS += /arch:AVX512
+    else: QMAKE_CXXFLAGS += -mavx512f
+}
 
 FORMS += \
     mainwindow.ui
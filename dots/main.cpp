@@ -61,12 +61,7 @@ int main(int argc, char *argv[])
         QString dataFileName = "../../../../test_files/r6.txt";
         dataFileName = "/Users/fatty/Code/GeoLife1.3/Data/000/Trajectory/20090403011657.plt";
         //dataFileName = "/Users/fatty/Code/MopsiDataset/1/1416074584000";
-        if (dataFileName.endsWith(".txt")) // MOPSI dataset.
-            Helper::parseMOPSI(dataFileName, x, y, t);
-        else if (dataFileName.endsWith(".plt")) // GeoLife dataset.
-            Helper::parseGeoLife(dataFileName, x, y, t);
-        else
-            Helper::parseMOPSI2(dataFileName, x, y, t);
+        Helper::parseTrajectory(dataFileName, x, y, t);
         qDebug("Parsing file OK, time: %d ms.", timer.elapsed());
 
         // Construct singular data for testing.
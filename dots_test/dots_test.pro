@@ -9,11 +9,20 @@ QT       += testlib
 QT       -= gui
 
 TARGET = tst_DotsSimplifierTest
-CONFIG   += console
+CONFIG   += console c++11
 CONFIG   -= app_bundle
 
 TEMPLATE = app
 
 
-SOURCES += tst_DotsSimplifierTest.cpp
+INCLUDEPATH += ../dots
+
+SOURCES += tst_DotsSimplifierTest.cpp \
+    ../dots/Helper.cpp \
+    ../dots/DotsException.cpp \
+    ../dots/TrajectoryReader.cpp \
+    ../dots/DateTimeDecoder.cpp \
+    ../dots/DotsSessionManager.cpp
+
+HEADERS += ../dots/DotsSessionManager.h
 DEFINES += SRCDIR=\\\"$$PWD/\\\"
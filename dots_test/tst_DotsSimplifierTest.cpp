@@ -6,6 +6,139 @@
 
 #include <QString>
 #include <QtTest>
+#include<QTemporaryDir>
+#include<QtMath>
+#include<cstring>
+#include<random>
+#include<vector>
+#include"DotsCore.h"
+#include"DotsException.h"
+#include"DotsSessionManager.h"
+#include"Helper.h"
+#include"PrefixStatistics.h"
+
+// Exposes the DAG of DotsCore, so that tests can check what streaming compaction retained and how ISSED was minimized.
+class DotsCoreProbe : public DotsCore
+{
+public:
+    // Returns a node that a Vk element reaches through its parents before the commit node, but that was dropped
+    // already, or -1 if there is none.
+    int droppedLiveNode(int commitNode) const
+    {
+        for (size_t k=0; k<vK.size(); ++k)
+        {
+            for (int node = vK[k]; node >= 0 && node != commitNode; node = parents[node-nodeOffset])
+            {
+                if (node < nodeOffset)
+                    return node;
+            }
+        }
+        return -1;
+    }
+
+    // Runs minimizeISSED() on the current Vl and compares the result with an exhaustive search over Vk in Vk order,
+    // which keeps the current parent on ties and otherwise takes the first Vk element. Returns the number of Vl
+    // elements that got another ISSED or parent, and adds the number of candidates that tied with the best to ties.
+    int checkMinimizeIssed(int &ties)
+    {
+        if (vL.empty())
+            return 0;
+        // The probe is not a cascade level, so it is its own root.
+        if (frontierGeneration != dataGeneration)
+            refreshFrontier();
+
+        std::vector<double> expectedIssed(vL.size());
+        std::vector<int> expectedParents(vL.size());
+        LssdPoint l;
+        for (size_t k=0; k<vL.size(); ++k)
+        {
+            int i = vL[k];
+            loadLastPoint(i, l);
+            std::vector<double> distances(vK.size(), -1);
+            double minDistance = issed[i-nodeOffset];
+            int minParent = parents[i-nodeOffset];
+            for (size_t m=0; m<vK.size(); ++m)
+            {
+                double localDistance = LssdKernel::lssd(frontier.get(m), l);
+                if (localDistance >= lssdTh)
+                    continue;
+                distances[m] = issed[vK[m]-nodeOffset]+localDistance;
+                if (distances[m] < minDistance)
+                {
+                    minDistance = distances[m];
+                    minParent = vK[m];
+                }
+            }
+            for (size_t m=0; m<vK.size(); ++m)
+            {
+                if (distances[m] == minDistance && vK[m] != minParent)
+                    ++ties;
+            }
+            expectedIssed[k] = minDistance;
+            expectedParents[k] = minParent;
+        }
+
+        minimizeISSED();
+        int mismatches = 0;
+        for (size_t k=0; k<vL.size(); ++k)
+        {
+            if (issed[vL[k]-nodeOffset] != expectedIssed[k] || parents[vL[k]-nodeOffset] != expectedParents[k])
+                ++mismatches;
+        }
+        return mismatches;
+    }
+};
+
+// Exposes the slot array of DotsSessionManager, so that tests can check that closed sessions are reused.
+class DotsSessionManagerProbe : public DotsSessionManager
+{
+public:
+    int slotCount() const
+    {
+        return static_cast<int>(sessions.size());
+    }
+};
+
+// Generates a noisy synthetic track at 1 second or more per point. The noise is drawn from the raw generator, as
+// distributions differ among libraries.
+static void generateTrack(uint seed, int count, std::vector<double> &x, std::vector<double> &y, std::vector<double> &t)
+{
+    std::mt19937 random(seed);
+    x.resize(count);
+    y.resize(count);
+    t.resize(count);
+    double heading = 0, time = 0;
+    for (int i=0; i<count; ++i)
+    {
+        double u1 = (random()+0.5)/4294967296.0, u2 = random()/4294967296.0;
+        heading += 0.2*std::sqrt(-2*std::log(u1))*std::cos(2*M_PI*u2);
+        double noiseX = (random()/4294967296.0-0.5)*10, noiseY = (random()/4294967296.0-0.5)*10;
+        x[i] = (i > 0 ? x[i-1] : 0)+5*std::cos(heading)+noiseX;
+        y[i] = (i > 0 ? y[i-1] : 0)+5*std::sin(heading)+noiseY;
+        time += 1+random()%3;
+        t[i] = time;
+    }
+}
+
+// Runs a track through a standalone simplifier in streaming mode, reading the outputs after every point if required.
+static std::vector<int> simplifyAlone(const std::vector<double> &x, const std::vector<double> &y,
+                                      const std::vector<double> &t, int maxPoints, bool readEachPoint)
+{
+    DotsCore simplifier;
+    simplifier.setParameters(1000);
+    simplifier.setStreamingMode(true);
+    simplifier.setMaxDelay(maxPoints);
+    std::vector<int> output;
+    for (size_t i=0; i<x.size(); ++i)
+    {
+        simplifier.feedData(x[i], y[i], t[i]);
+        if (readEachPoint)
+            simplifier.drainOutput(output);
+    }
+    simplifier.finish();
+    simplifier.drainOutput(output);
+    return output;
+}
 
 class DotsSimplifierTest : public QObject
 {
@@ -19,6 +152,21 @@ private Q_SLOTS:
     void cleanupTestCase();
     void testCase1_data();
     void testCase1();
+    void testMaxDelayKeepsOrder_data();
+    void testMaxDelayKeepsOrder();
+    void testBinaryRoundTrip();
+    void testBinaryRejectsDamage_data();
+    void testBinaryRejectsDamage();
+    void testLssdOfLongAbsoluteTrack();
+    void testOutputBudgetOnBundledTrack_data();
+    void testOutputBudgetOnBundledTrack();
+    void testStreamingKeepsBackwardLinkedNodes_data();
+    void testStreamingKeepsBackwardLinkedNodes();
+    void testPrunedMinimizeIssed_data();
+    void testPrunedMinimizeIssed();
+    void testSessionsMatchStandaloneStreams_data();
+    void testSessionsMatchStandaloneStreams();
+    void testIdleSessionsExpireInFeedOrder();
 };
 
 DotsSimplifierTest::DotsSimplifierTest()
@@ -45,6 +193,521 @@ void DotsSimplifierTest::testCase1()
     QVERIFY2(false, "Failure");
 }
 
+void DotsSimplifierTest::testMaxDelayKeepsOrder_data()
+{
+    // Seeds of tracks on which forced commits used to link undecided points to later points, or to wait for them.
+    QTest::addColumn<uint>("seed");
+    QTest::addColumn<int>("maxPoints");
+    QTest::addColumn<double>("maxSeconds");
+    QTest::addColumn<bool>("streaming");
+    QTest::addColumn<int>("packetSize");
+    QTest::newRow("10 points") << 48u << 10 << 0.0 << false << 1;
+    QTest::newRow("20 points") << 17u << 20 << 0.0 << false << 1;
+    QTest::newRow("60 seconds") << 98u << 0 << 60.0 << false << 1;
+    QTest::newRow("10 points, streaming") << 48u << 10 << 0.0 << true << 1;
+    QTest::newRow("20 points, streaming") << 17u << 20 << 0.0 << true << 1;
+    QTest::newRow("60 seconds, streaming") << 98u << 0 << 60.0 << true << 1;
+    QTest::newRow("10 points, streaming packets") << 48u << 10 << 0.0 << true << 256;
+    QTest::newRow("60 seconds, streaming packets") << 98u << 0 << 60.0 << true << 256;
+}
+
+void DotsSimplifierTest::testMaxDelayKeepsOrder()
+{
+    QFETCH(uint, seed);
+    QFETCH(int, maxPoints);
+    QFETCH(double, maxSeconds);
+    QFETCH(bool, streaming);
+    QFETCH(int, packetSize);
+
+    // A slow and noisy synthetic track with recording gaps, on which points often stay undecided while later points
+    // are decided already. The noise is drawn from the raw generator, as distributions differ among libraries.
+    const int POINT_COUNT = 50000;
+    std::mt19937 random(seed);
+    std::vector<double> x(POINT_COUNT), y(POINT_COUNT), t(POINT_COUNT);
+    double heading = 0, time = 0;
+    for (int i=0; i<POINT_COUNT; ++i)
+    {
+        double u1 = (random()+0.5)/4294967296.0, u2 = random()/4294967296.0;
+        heading += 0.06*std::sqrt(-2*std::log(u1))*std::cos(2*M_PI*u2);
+        double noiseX = (random()/4294967296.0-0.5)*16, noiseY = (random()/4294967296.0-0.5)*16;
+        x[i] = (i > 0 ? x[i-1] : 0)+1.4*std::cos(heading)+noiseX;
+        y[i] = (i > 0 ? y[i-1] : 0)+1.4*std::sin(heading)+noiseY;
+        time += (random()%10 == 0) ? 1+random()%100 : 1;
+        t[i] = time;
+    }
+
+    DotsCore simplifier;
+    simplifier.setParameters(1000);
+    simplifier.setStreamingMode(streaming);
+    simplifier.setMaxDelay(maxPoints, maxSeconds);
+    std::vector<int> output;
+    for (int i=0; i<POINT_COUNT; i+=packetSize)
+    {
+        int n = std::min(packetSize, POINT_COUNT-i);
+        simplifier.feedBatch(&x[i], &y[i], &t[i], n);
+        simplifier.drainOutput(output);
+
+        // The newest point must be within the bound from the last output point after every feed.
+        int newest = i+n-1, last = output.empty() ? 0 : output.back();
+        if ((maxPoints > 0 && newest-last > maxPoints) || (maxSeconds > 0 && t[newest]-t[last] > maxSeconds))
+            QFAIL(qPrintable(QString("Point %1 was fed while point %2 was the last output.").arg(newest).arg(last)));
+    }
+    simplifier.finish();
+    simplifier.drainOutput(output);
+
+    // The bound must have fired, and the output must still be the first point, increasing indices and the last point.
+    QVERIFY(simplifier.getForcedCommitCount() > 0);
+    QCOMPARE(output.front(), 0);
+    QCOMPARE(output.back(), POINT_COUNT-1);
+    for (size_t k=1; k<output.size(); ++k)
+    {
+        if (output[k] <= output[k-1])
+            QFAIL(qPrintable(QString("Output %1 follows output %2.").arg(output[k]).arg(output[k-1])));
+    }
+}
+
+void DotsSimplifierTest::testBinaryRoundTrip()
+{
+    // A projected and normalized trajectory, stored at 1 mm and 1 ms.
+    const int POINT_COUNT = 10000;
+    const double XY_RESOLUTION = 1e-3, T_RESOLUTION = 1e-3;
+    std::mt19937 random(11);
+    QVector<double> x, y, t;
+    double time = 0;
+    for (int i=0; i<POINT_COUNT; ++i)
+    {
+        x.append((random()/4294967296.0-0.5)*2e5);
+        y.append((random()/4294967296.0-0.5)*2e5);
+        time += 0.5+random()%100000/1000.0;
+        t.append(time);
+    }
+    TrajectoryFrame frame(0.75, 1.25e7, -3.5e6, 1.4e9);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path()+"/trajectory"+Helper::BINARY_SUFFIX;
+    Helper::writeBinary(fileName, x, y, t, frame, XY_RESOLUTION, T_RESOLUTION);
+
+    QVector<double> parsedX, parsedY, parsedT;
+    TrajectoryFrame parsedFrame;
+    Helper::parseBinary(fileName, parsedX, parsedY, parsedT, &parsedFrame);
+
+    // Values are within half the resolution, allowing for the rounding of the decoded multiples of it.
+    QCOMPARE(parsedX.count(), POINT_COUNT);
+    QCOMPARE(parsedY.count(), POINT_COUNT);
+    QCOMPARE(parsedT.count(), POINT_COUNT);
+    for (int i=0; i<POINT_COUNT; ++i)
+    {
+        QVERIFY(std::fabs(parsedX[i]-x[i]) <= 0.5*XY_RESOLUTION+1e-9);
+        QVERIFY(std::fabs(parsedY[i]-y[i]) <= 0.5*XY_RESOLUTION+1e-9);
+        QVERIFY(std::fabs(parsedT[i]-t[i]) <= 0.5*T_RESOLUTION+1e-9);
+    }
+    QCOMPARE(parsedFrame.scaleFactor, frame.scaleFactor);
+    QCOMPARE(parsedFrame.offsetX, frame.offsetX);
+    QCOMPARE(parsedFrame.offsetY, frame.offsetY);
+    QCOMPARE(parsedFrame.offsetT, frame.offsetT);
+}
+
+void DotsSimplifierTest::testBinaryRejectsDamage_data()
+{
+    QTest::addColumn<QString>("damage");
+    QTest::newRow("magic") << QString("magic");
+    QTest::newRow("truncated header") << QString("truncated header");
+    QTest::newRow("truncated column") << QString("truncated column");
+    QTest::newRow("unterminated value") << QString("unterminated value");
+    QTest::newRow("point count") << QString("point count");
+    QTest::newRow("column size") << QString("column size");
+}
+
+void DotsSimplifierTest::testBinaryRejectsDamage()
+{
+    QFETCH(QString, damage);
+
+    QVector<double> x, y, t;
+    for (int i=0; i<1000; ++i)
+    {
+        x.append(std::cos(i*0.01)*1000);
+        y.append(std::sin(i*0.01)*1000);
+        t.append(i);
+    }
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path()+"/trajectory"+Helper::BINARY_SUFFIX;
+    Helper::writeBinary(fileName, x, y, t);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray bytes = file.readAll();
+    file.close();
+
+    // The header holds the magic, the version and the point count, the frame and the resolutions, and the sizes of
+    // the x, y and t columns, which follow it.
+    const int POINT_COUNT_OFFSET = 2*sizeof(qint32);
+    const int COLUMN_SIZE_OFFSET = 3*sizeof(qint32)+6*sizeof(double);
+    const int HEADER_SIZE = COLUMN_SIZE_OFFSET+3*sizeof(qint64);
+    if (damage == "magic")
+    {
+        bytes[0] = bytes[0]^0x55;
+    }
+    else if (damage == "truncated header")
+    {
+        bytes = bytes.left(HEADER_SIZE-1);
+    }
+    else if (damage == "truncated column")
+    {
+        bytes = bytes.left(bytes.size()-1);
+    }
+    else if (damage == "unterminated value")
+    {
+        // Set the continuation bit of the last byte, so that the last value runs past the end of the file.
+        bytes[bytes.size()-1] = bytes[bytes.size()-1]|0x80;
+    }
+    else if (damage == "point count")
+    {
+        qint32 pointCount;
+        memcpy(&pointCount, bytes.constData()+POINT_COUNT_OFFSET, sizeof(pointCount));
+        ++pointCount;
+        memcpy(bytes.data()+POINT_COUNT_OFFSET, &pointCount, sizeof(pointCount));
+    }
+    else if (damage == "column size")
+    {
+        qint64 columnSize;
+        memcpy(&columnSize, bytes.constData()+COLUMN_SIZE_OFFSET, sizeof(columnSize));
+        ++columnSize;
+        memcpy(bytes.data()+COLUMN_SIZE_OFFSET, &columnSize, sizeof(columnSize));
+    }
+
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(bytes), static_cast<qint64>(bytes.size()));
+    file.close();
+    QVector<double> parsedX, parsedY, parsedT;
+    QVERIFY_EXCEPTION_THROWN(Helper::parseBinary(fileName, parsedX, parsedY, parsedT), DotsException);
+}
+
+void DotsSimplifierTest::testLssdOfLongAbsoluteTrack()
+{
+    // A 1 Hz track of a million points in projected meters and Unix epoch seconds, moving 10 meters per second.
+    const int POINT_COUNT = 1000000;
+    std::mt19937 random(7);
+    std::vector<double> x(POINT_COUNT), y(POINT_COUNT), t(POINT_COUNT);
+    double heading = 0, px = 3.5e6, py = 5.9e6;
+    for (int i=0; i<POINT_COUNT; ++i)
+    {
+        heading += (random()/4294967296.0-0.5)*0.2;
+        px += 10*std::cos(heading);
+        py += 10*std::sin(heading);
+        x[i] = px+(random()/4294967296.0-0.5)*10;
+        y[i] = py+(random()/4294967296.0-0.5)*10;
+        t[i] = 1.5e9+i;
+    }
+    PrefixStatistics statistics(x.data(), y.data(), t.data(), POINT_COUNT);
+
+    // Segments at the end of the track, evaluated one by one and as a frontier, against LSSD computed directly.
+    const int LENGTHS[] = {10, 100, 1000};
+    const int lst = POINT_COUNT-1;
+    LssdFrontier frontier;
+    frontier.resize(3);
+    for (int k=0; k<3; ++k)
+    {
+        LssdPoint f;
+        statistics.getFirstPoint(lst-LENGTHS[k], f);
+        frontier.set(k, f);
+    }
+    LssdPoint l;
+    statistics.getLastPoint(lst, l);
+    double batched[3];
+    LssdKernel::evaluate(frontier, 0, 3, l, batched);
+    for (int k=0; k<3; ++k)
+    {
+        int fst = lst-LENGTHS[k];
+        long double expected = 0;
+        for (int i=fst+1; i<lst; ++i)
+        {
+            long double ratio = static_cast<long double>(t[i]-t[fst])/(t[lst]-t[fst]);
+            long double dx = x[fst]+ratio*(x[lst]-x[fst])-x[i], dy = y[fst]+ratio*(y[lst]-y[fst])-y[i];
+            expected += dx*dx+dy*dy;
+        }
+        double actual = statistics.lssd(fst, lst);
+        if (qAbs(actual-expected) > 1e-4*expected || qAbs(batched[k]-expected) > 1e-4*expected)
+            QFAIL(qPrintable(QString("LSSD of %1 points is %2 and %3 instead of %4.").arg(LENGTHS[k])
+                             .arg(actual).arg(batched[k]).arg(static_cast<double>(expected))));
+    }
+}
+
+void DotsSimplifierTest::testOutputBudgetOnBundledTrack_data()
+{
+    // Small ratios leave only a few layers to correct a poor initial threshold in, so they are the hard cases.
+    QTest::addColumn<double>("ratio");
+    QTest::addColumn<double>("initialThreshold");
+    const double RATIOS[] = {0.002, 0.005, 0.01, 0.05, 0.1};
+    const double THRESHOLDS[] = {1, 1e4, 1e8};
+    for (double ratio : RATIOS)
+    {
+        for (double threshold : THRESHOLDS)
+        {
+            QString name = QString("ratio %1, threshold %2").arg(ratio).arg(threshold);
+            QTest::newRow(qPrintable(name)) << ratio << threshold;
+        }
+    }
+}
+
+void DotsSimplifierTest::testOutputBudgetOnBundledTrack()
+{
+    QFETCH(double, ratio);
+    QFETCH(double, initialThreshold);
+
+    QVector<double> x, y, t;
+    Helper::parseMOPSI(SRCDIR "../test_files/r6.txt", x, y, t);
+    QVERIFY(x.count() > 1000);
+
+    DotsCore simplifier;
+    simplifier.setParameters(initialThreshold);
+    simplifier.setOutputBudget(ratio);
+    std::vector<int> output;
+    simplifier.feedBatch(x.constData(), y.constData(), t.constData(), x.count());
+    simplifier.finish();
+    simplifier.drainOutput(output);
+
+    // The achieved count must be within 10% of the budget, or within two points where that is looser.
+    double target = ratio*x.count();
+    int kept = static_cast<int>(output.size());
+    if (qAbs(kept-target) > qMax(2.0, 0.1*target))
+        QFAIL(qPrintable(QString("%1 points were kept instead of %2.").arg(kept).arg(target)));
+}
+
+void DotsSimplifierTest::testStreamingKeepsBackwardLinkedNodes_data()
+{
+    // Seeds of tracks on which compaction used to drop Vk elements linked to a parent with a greater index.
+    QTest::addColumn<uint>("seed");
+    QTest::newRow("31") << 31u;
+    QTest::newRow("98") << 98u;
+}
+
+void DotsSimplifierTest::testStreamingKeepsBackwardLinkedNodes()
+{
+    QFETCH(uint, seed);
+
+    // A fast and noisy synthetic track. The noise is drawn from the raw generator, as distributions differ among
+    // libraries.
+    const int POINT_COUNT = 2000;
+    std::mt19937 random(seed);
+    auto gaussian = [&random](double sigma) {
+        double u1 = (random()+0.5)/4294967296.0, u2 = random()/4294967296.0;
+        return sigma*std::sqrt(-2*std::log(u1))*std::cos(2*M_PI*u2);
+    };
+    std::vector<double> x(POINT_COUNT), y(POINT_COUNT), t(POINT_COUNT);
+    double positionX = 0, positionY = 0, heading = 0, time = 0;
+    for (int i=0; i<POINT_COUNT; ++i)
+    {
+        heading += gaussian(0.2);
+        double speed = 5+std::fabs(gaussian(5));
+        positionX += speed*std::cos(heading);
+        positionY += speed*std::sin(heading);
+        time += 1+random()%3;
+        x[i] = positionX+gaussian(5);
+        y[i] = positionY+gaussian(5);
+        t[i] = time;
+    }
+
+    // Streaming mode must neither drop a live node nor change the output.
+    std::vector<int> expected, output;
+    DotsCore reference;
+    reference.setParameters(1000);
+    DotsCoreProbe simplifier;
+    simplifier.setParameters(1000);
+    simplifier.setStreamingMode(true);
+    for (int i=0; i<POINT_COUNT; ++i)
+    {
+        reference.feedData(x[i], y[i], t[i]);
+        reference.drainOutput(expected);
+        simplifier.feedData(x[i], y[i], t[i]);
+        simplifier.drainOutput(output);
+        int dropped = output.empty() ? -1 : simplifier.droppedLiveNode(output.back());
+        if (dropped >= 0)
+            QFAIL(qPrintable(QString("Node %1 was dropped while point %2 was fed.").arg(dropped).arg(i)));
+    }
+    reference.finish();
+    reference.drainOutput(expected);
+    simplifier.finish();
+    simplifier.drainOutput(output);
+    QVERIFY(output == expected);
+}
+
+void DotsSimplifierTest::testPrunedMinimizeIssed_data()
+{
+    QTest::addColumn<bool>("zigzag");
+    QTest::addColumn<double>("threshold");
+    QTest::newRow("bundled track, 100") << false << 100.0;
+    QTest::newRow("bundled track, 10000") << false << 1e4;
+    QTest::newRow("zigzag, 10") << true << 10.0;
+    QTest::newRow("zigzag, 100") << true << 100.0;
+}
+
+void DotsSimplifierTest::testPrunedMinimizeIssed()
+{
+    QFETCH(bool, zigzag);
+    QFETCH(double, threshold);
+
+    // A regular zigzag gives equal LSSD to segments of a length that start on the same side, and thereby many tied
+    // ISSED values.
+    QVector<double> x, y, t;
+    if (zigzag)
+    {
+        for (int i=0; i<2000; ++i)
+        {
+            x.append(i);
+            y.append(i%2);
+            t.append(i);
+        }
+    }
+    else
+    {
+        Helper::parseMOPSI(SRCDIR "../test_files/r6.txt", x, y, t);
+    }
+
+    DotsCoreProbe simplifier;
+    simplifier.setParameters(threshold);
+    std::vector<int> output;
+    int ties = 0;
+    for (int i=0; i<x.count(); ++i)
+    {
+        // Draining runs the DAG search, which leaves the Vl being built.
+        simplifier.feedData(x[i], y[i], t[i]);
+        simplifier.drainOutput(output);
+        int mismatches = simplifier.checkMinimizeIssed(ties);
+        if (mismatches > 0)
+            QFAIL(qPrintable(QString("%1 Vl elements differ after point %2.").arg(mismatches).arg(i)));
+    }
+    if (zigzag)
+        QVERIFY(ties > 0);
+}
+
+void DotsSimplifierTest::testSessionsMatchStandaloneStreams_data()
+{
+    QTest::addColumn<int>("maxPoints");
+    QTest::newRow("no delay bound") << 0;
+    QTest::newRow("20 points") << 20;
+}
+
+void DotsSimplifierTest::testSessionsMatchStandaloneStreams()
+{
+    QFETCH(int, maxPoints);
+
+    // Four streams start at once, and a fifth one starts when the first of them is closed, so that it reuses its slot.
+    const int STREAM_COUNT = 5;
+    const int LENGTHS[STREAM_COUNT] = {3000, 1200, 2500, 2000, 1500};
+    const qint64 IDS[STREAM_COUNT] = {7, 1LL << 40, -3, 1000000007, 8};
+    std::vector<double> x[STREAM_COUNT], y[STREAM_COUNT], t[STREAM_COUNT];
+    std::vector<int> expected[STREAM_COUNT], output[STREAM_COUNT];
+    for (int s=0; s<STREAM_COUNT; ++s)
+    {
+        generateTrack(100+s, LENGTHS[s], x[s], y[s], t[s]);
+        expected[s] = simplifyAlone(x[s], y[s], t[s], maxPoints, true);
+    }
+
+    // Interleave bursts of records of randomly picked streams, reading the outputs after every record.
+    DotsSessionManagerProbe manager;
+    manager.setParameters(1000);
+    manager.setMaxDelay(maxPoints);
+    std::mt19937 random(5);
+    int fed[STREAM_COUNT] = {0};
+    int closedCount = 0;
+    while (closedCount < STREAM_COUNT)
+    {
+        int s = random()%(closedCount > 0 ? STREAM_COUNT : STREAM_COUNT-1);
+        if (fed[s] == LENGTHS[s])
+            continue;
+        int burst = std::min(1+static_cast<int>(random()%8), LENGTHS[s]-fed[s]);
+        for (int k=0; k<burst; ++k, ++fed[s])
+        {
+            manager.feedData(IDS[s], x[s][fed[s]], y[s][fed[s]], t[s][fed[s]]);
+            int index;
+            while (manager.readOutputIndex(IDS[s], index))
+                output[s].push_back(index);
+        }
+        if (fed[s] < LENGTHS[s])
+            continue;
+
+        QVector<int> remainingIndex;
+        manager.closeSession(IDS[s], remainingIndex);
+        output[s].insert(output[s].end(), remainingIndex.begin(), remainingIndex.end());
+        QVERIFY(!manager.hasSession(IDS[s]));
+        if (closedCount++ > 0)
+            continue;
+
+        // The last stream starts in the released slot at once, and reads of the closed stream must not reach it.
+        int last = STREAM_COUNT-1, index;
+        manager.feedData(IDS[last], x[last][0], y[last][0], t[last][0]);
+        ++fed[last];
+        QVERIFY(!manager.readOutputIndex(IDS[s], index));
+        while (manager.readOutputIndex(IDS[last], index))
+            output[last].push_back(index);
+    }
+
+    for (int s=0; s<STREAM_COUNT; ++s)
+    {
+        if (output[s] != expected[s])
+            QFAIL(qPrintable(QString("Stream %1 differs from a standalone simplifier.").arg(IDS[s])));
+    }
+    QCOMPARE(manager.sessionCount(), 0);
+    QCOMPARE(manager.slotCount(), STREAM_COUNT-1);
+}
+
+void DotsSimplifierTest::testIdleSessionsExpireInFeedOrder()
+{
+    // Streams share a clock. Each stream gets 50 records, then streams 3 and 1 get 10 more each, so the streams were
+    // last fed in the order 2, 4, 5, 3, 1.
+    const int STREAM_COUNT = 5;
+    std::vector<double> x[STREAM_COUNT], y[STREAM_COUNT], t[STREAM_COUNT];
+    for (int s=0; s<STREAM_COUNT; ++s)
+        generateTrack(200+s, 60, x[s], y[s], t[s]);
+
+    DotsSessionManagerProbe manager;
+    manager.setParameters(1000);
+    std::vector<int> fedStreams;
+    for (int s=0; s<STREAM_COUNT; ++s)
+        fedStreams.insert(fedStreams.end(), 50, s);
+    fedStreams.insert(fedStreams.end(), 10, 2);
+    fedStreams.insert(fedStreams.end(), 10, 0);
+    int fed[STREAM_COUNT] = {0};
+    double now = 0;
+    for (size_t k=0; k<fedStreams.size(); ++k, ++now)
+    {
+        int s = fedStreams[k];
+        manager.feedData(s+1, x[s][fed[s]], y[s][fed[s]], now);
+        t[s][fed[s]++] = now;
+    }
+    QCOMPARE(manager.sessionCount(), STREAM_COUNT);
+
+    // Streams 2, 4 and 5 were last fed before 255, while stream 3 was fed at 259, which stops the check.
+    QVector<qint64> expiredIds;
+    QVector<QVector<int> > remainingIndex;
+    QCOMPARE(manager.expireIdleSessions(260, 5, expiredIds, remainingIndex), 3);
+    QCOMPARE(expiredIds, QVector<qint64>() << 2 << 4 << 5);
+    QCOMPARE(remainingIndex.count(), 3);
+    for (int k=0; k<expiredIds.count(); ++k)
+    {
+        // No outputs were read, so the remaining ones are the whole output of the stream.
+        int s = static_cast<int>(expiredIds[k])-1;
+        x[s].resize(fed[s]);
+        y[s].resize(fed[s]);
+        t[s].resize(fed[s]);
+        std::vector<int> expected = simplifyAlone(x[s], y[s], t[s], 0, false);
+        QVERIFY(std::vector<int>(remainingIndex[k].begin(), remainingIndex[k].end()) == expected);
+        QVERIFY(!manager.hasSession(expiredIds[k]));
+    }
+    QCOMPARE(manager.sessionCount(), 2);
+    QVERIFY(manager.hasSession(1));
+    QVERIFY(manager.hasSession(3));
+
+    // Nothing else is idle yet, and a new stream reuses a released slot.
+    QCOMPARE(manager.expireIdleSessions(260, 5, expiredIds, remainingIndex), 0);
+    QVERIFY(expiredIds.isEmpty());
+    manager.feedData(6, 0, 0, now);
+    QCOMPARE(manager.sessionCount(), 3);
+    QCOMPARE(manager.slotCount(), STREAM_COUNT);
+}
+
 QTEST_APPLESS_MAIN(DotsSimplifierTest)
 
 #include "tst_DotsSimplifierTest.moc"